@@ -0,0 +1,440 @@
+// End-to-end rendering benchmark over a fixed set of scenes. Every scene is built from fixed seeds and
+// rendered with fixed frame indices, so results are comparable between builds on the same machine.
+// Writes one JSON object per scene to --output (default bench_results.json).
+#include "scene/Scene.h"
+#include "scene/Camera.h"
+#include "geometry/Sphere.h"
+#include "geometry/Plane.h"
+#include "geometry/Mesh.h"
+#include "geometry/Transform.h"
+#include "materials/Lambertian.h"
+#include "materials/Metal.h"
+#include "materials/Dielectric.h"
+#include "renderer/Renderer.h"
+#include "renderer/BatchRender.h"
+#include "renderer/TileScheduler.h"
+#include "utils/ThreadPool.h"
+#include "utils/MemoryStats.h"
+#include "utils/RenderStats.h"
+#include "core/Random.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// The build points this at the source tree so the benchmark finds monkey.obj from any working directory
+#ifndef RT_BENCH_MODELS_DIR
+#define RT_BENCH_MODELS_DIR "models"
+#endif
+
+namespace {
+struct BenchSettings {
+    int width = 400;
+    int height = 225;
+    int samplesPerPixel = 4;
+    int maxDepth = 8;
+    int frames = 5;
+    int threadCount = 0;
+    int scalingThreads = 0; // When set, also renders each scene on 1, 2, 4, ... up to this many threads
+    std::string modelsPath = RT_BENCH_MODELS_DIR;
+    std::string outputPath = "bench_results.json";
+    std::string only; // Runs only the scene with this name when set
+};
+
+struct BenchScene {
+    std::string name;
+    // Fills the scene and points the camera; returns false when an asset is missing
+    std::function<bool(Scene&, Camera&, std::vector<std::shared_ptr<Mesh>>&)> build;
+};
+
+struct ScalingPoint {
+    int threads = 0;
+    double msPerFrame = 0.0;
+    double mraysPerSecond = 0.0;
+};
+
+struct BenchResult {
+    std::string name;
+    bool ok = false;
+    size_t objects = 0;
+    double buildMs = 0.0;
+    double primarySingleMraysPerSecond = 0.0;
+    double primaryPacketMraysPerSecond = 0.0;
+    double msPerFrameMean = 0.0;
+    double msPerFrameMin = 0.0;
+    double mraysPerSecond = 0.0;
+    double averagePathLength = 0.0;
+    double peakResidentMB = 0.0;
+    RenderStats counters;
+    std::vector<ScalingPoint> scaling;
+};
+
+std::shared_ptr<Transform> Place(std::shared_ptr<Hittable> object, const Vec3& position, const Vec3& scale) {
+    auto transform = std::make_shared<Transform>(object);
+    transform->SetPosition(position);
+    transform->SetScale(scale);
+    return transform;
+}
+
+std::shared_ptr<Mesh> LoadMonkey(const BenchSettings& settings, uint32_t materialId) {
+    auto mesh = std::make_shared<Mesh>(materialId);
+    if (!mesh->LoadFromOBJ(settings.modelsPath + "/monkey.obj")) return nullptr;
+    return mesh;
+}
+
+std::vector<BenchScene> CanonicalScenes(const BenchSettings& settings) {
+    std::vector<BenchScene> scenes;
+
+    // The interactive demo: glass sphere, metal ground plane and the monkey
+    scenes.push_back({ "demo", [&settings](Scene& scene, Camera&, std::vector<std::shared_ptr<Mesh>>& meshes) {
+        auto glass = scene.AddMaterial(std::make_shared<Dielectric>(1.05f));
+        auto metal = scene.AddMaterial(std::make_shared<Metal>(Vec3(0.2f, 0.2f, 0.4f)));
+        auto ground = scene.AddMaterial(std::make_shared<Lambertian>(Vec3(0.8f, 0.8f, 0.0f)));
+        auto sphere = Place(std::make_shared<Sphere>(glass), Vec3(1.25f, -0.5f, -2), Vec3(0.5f, 0.5f, 0.5f));
+        sphere->SetRotation(Vec3(0, 45, 45));
+        scene.Add(sphere);
+        scene.Add(Place(std::make_shared<Plane>(metal), Vec3(0, -1.2f, -5), Vec3(5, 5, 5)));
+        auto monkey = LoadMonkey(settings, ground);
+        if (!monkey) return false;
+        scene.AddInstance(monkey, Vec3(0, -0.75f, -2), Vec3(0, 30, 0), Vec3(0.5f, 0.5f, 0.5f));
+        meshes.push_back(monkey);
+        return true;
+    } });
+
+    // monkey.obj filling the frame over a diffuse ground
+    scenes.push_back({ "monkey", [&settings](Scene& scene, Camera&, std::vector<std::shared_ptr<Mesh>>& meshes) {
+        auto red = scene.AddMaterial(std::make_shared<Lambertian>(Vec3(0.7f, 0.3f, 0.3f)));
+        auto monkey = LoadMonkey(settings, red);
+        if (!monkey) return false;
+        scene.AddInstance(monkey, Vec3(0, 0, -1.6f), Vec3(0, 0, 0), Vec3(0.7f, 0.7f, 0.7f));
+        auto floor = scene.AddMaterial(std::make_shared<Lambertian>(Vec3(0.5f, 0.5f, 0.5f)));
+        scene.Add(Place(std::make_shared<Plane>(floor),
+            Vec3(0, -0.8f, -3), Vec3(5, 5, 5)));
+        meshes.push_back(monkey);
+        return true;
+    } });
+
+    // 100 x 100 small spheres on a ground plane, diffuse and metal with seeded colors
+    scenes.push_back({ "spheres10k", [](Scene& scene, Camera& camera, std::vector<std::shared_ptr<Mesh>>&) {
+        RandomStream rng(0x5eed, 0, 0);
+        for (int i = 0; i < 100; i++) {
+            for (int j = 0; j < 100; j++) {
+                Vec3 color(rng.NextFloat(), rng.NextFloat(), rng.NextFloat());
+                uint32_t material;
+                if (rng.NextFloat() < 0.8f) material = scene.AddMaterial(std::make_shared<Lambertian>(color));
+                else material = scene.AddMaterial(std::make_shared<Metal>(color));
+                float radius = 0.05f + 0.05f * rng.NextFloat();
+                Vec3 position((i - 50) * 0.25f + 0.1f * rng.NextFloat(), -1.0f + radius, -1.5f - j * 0.25f);
+                scene.Add(Place(std::make_shared<Sphere>(material), position, Vec3(radius, radius, radius)));
+            }
+        }
+        auto floor = scene.AddMaterial(std::make_shared<Lambertian>(Vec3(0.5f, 0.5f, 0.5f)));
+        scene.Add(Place(std::make_shared<Plane>(floor),
+            Vec3(0, -1.0f, -10), Vec3(20, 20, 20)));
+        camera.SetPitch(-0.3f);
+        camera.UpdateVectors();
+        return true;
+    } });
+
+    // A grid of glass spheres in front of a glass monkey: long refraction paths everywhere
+    scenes.push_back({ "glass", [&settings](Scene& scene, Camera&, std::vector<std::shared_ptr<Mesh>>& meshes) {
+        auto glass = scene.AddMaterial(std::make_shared<Dielectric>(1.5f));
+        for (int i = 0; i < 5; i++) {
+            for (int j = 0; j < 3; j++) {
+                scene.Add(Place(std::make_shared<Sphere>(glass), Vec3((i - 2) * 0.7f, (j - 1) * 0.6f, -2.5f),
+                    Vec3(0.28f, 0.28f, 0.28f)));
+            }
+        }
+        auto floor = scene.AddMaterial(std::make_shared<Lambertian>(Vec3(0.8f, 0.8f, 0.8f)));
+        scene.Add(Place(std::make_shared<Plane>(floor),
+            Vec3(0, -1.0f, -4), Vec3(5, 5, 5)));
+        auto monkey = LoadMonkey(settings, glass);
+        if (!monkey) return false;
+        scene.AddInstance(monkey, Vec3(0, 0, -4), Vec3(0, 0, 0), Vec3(0.8f, 0.8f, 0.8f));
+        meshes.push_back(monkey);
+        return true;
+    } });
+
+    return scenes;
+}
+
+BenchResult RunScene(const BenchScene& benchScene, const BenchSettings& settings, ThreadPool& pool) {
+    using Clock = std::chrono::steady_clock;
+    BenchResult result;
+    result.name = benchScene.name;
+
+    Scene scene;
+    Camera camera;
+    camera.SetAspectRatio(float(settings.width) / settings.height);
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    if (!benchScene.build(scene, camera, meshes)) {
+        std::cerr << "Skipping scene " << benchScene.name << ": missing assets" << std::endl;
+        return result;
+    }
+    result.objects = scene.GetObjectCount() + scene.GetInstanceCount();
+
+    Clock::time_point buildStart = Clock::now();
+    for (const auto& mesh : meshes) mesh->BuildBVH();
+    scene.BuildBVH();
+    result.buildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+
+    Renderer renderer;
+    renderer.packetSize = 4;
+    renderer.sampler = CreateSampler(SamplerType::Sobol, settings.samplesPerPixel);
+    PrimaryRayThroughput primary = renderer.MeasurePrimaryThroughput(camera, scene, settings.width, settings.height, 4);
+    result.primarySingleMraysPerSecond = primary.singleRaysPerSecond / 1e6;
+    result.primaryPacketMraysPerSecond = primary.packetRaysPerSecond / 1e6;
+
+    TileScheduler scheduler;
+    scheduler.Build(settings.width, settings.height, 16);
+    std::vector<Vec3> colors;
+
+    // One untimed warm-up frame, then fixed frame indices
+    renderer.frameIndex = 0;
+    RenderPass(camera, scene, renderer, scheduler, &pool, settings.width, settings.height, settings.samplesPerPixel,
+        settings.maxDepth, colors);
+    renderer.ResetPathStats();
+    RenderStats countersAtStart = CollectRenderStats();
+
+    double totalMs = 0.0;
+    result.msPerFrameMin = 0.0;
+    for (int frame = 0; frame < settings.frames; frame++) {
+        renderer.frameIndex = static_cast<uint32_t>(frame + 1);
+        Clock::time_point frameStart = Clock::now();
+        RenderPass(camera, scene, renderer, scheduler, &pool, settings.width, settings.height,
+            settings.samplesPerPixel, settings.maxDepth, colors);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+        totalMs += ms;
+        result.msPerFrameMin = frame == 0 ? ms : std::min(result.msPerFrameMin, ms);
+    }
+
+    double paths = double(settings.width) * settings.height * settings.samplesPerPixel * settings.frames;
+    result.averagePathLength = renderer.AveragePathLength();
+    result.msPerFrameMean = settings.frames > 0 ? totalMs / settings.frames : 0.0;
+    result.mraysPerSecond = totalMs > 0.0 ? paths * result.averagePathLength / (totalMs * 1e3) : 0.0;
+    result.peakResidentMB = GetPeakResidentBytes() / (1024.0 * 1024.0);
+    result.counters = CollectRenderStats() - countersAtStart;
+
+    // The same frames on growing pools. State shared between threads on the hit path (a reference count
+    // bumped per hit, a contended counter) shows as throughput that stops growing with the thread count.
+    for (int threads = 1; settings.scalingThreads > 0; threads = std::min(threads * 2, settings.scalingThreads)) {
+        ThreadPool scalingPool(threads);
+        renderer.ResetPathStats();
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < settings.frames; frame++) {
+            renderer.frameIndex = static_cast<uint32_t>(frame + 1);
+            RenderPass(camera, scene, renderer, scheduler, &scalingPool, settings.width, settings.height,
+                settings.samplesPerPixel, settings.maxDepth, colors);
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        ScalingPoint point;
+        point.threads = threads;
+        point.msPerFrame = ms / settings.frames;
+        point.mraysPerSecond = ms > 0.0 ? paths * renderer.AveragePathLength() / (ms * 1e3) : 0.0;
+        result.scaling.push_back(point);
+        if (threads == settings.scalingThreads) break;
+    }
+    result.ok = true;
+    return result;
+}
+
+// Frame time of the single-thread point over this one; 0 when a point was too fast to time, since an
+// infinite ratio is not valid JSON
+double Speedup(const ScalingPoint& base, const ScalingPoint& point) {
+    return point.msPerFrame > 0.0 ? base.msPerFrame / point.msPerFrame : 0.0;
+}
+
+void WriteSceneJSON(std::ostream& out, const BenchResult& r) {
+    out << "{ \"name\": \"" << r.name << "\", \"ok\": " << (r.ok ? "true" : "false");
+    if (r.ok) {
+        out << ", \"objects\": " << r.objects
+            << ", \"bvh_build_ms\": " << r.buildMs
+            << ", \"primary_mrays_per_s\": " << r.primarySingleMraysPerSecond
+            << ", \"primary_packet_mrays_per_s\": " << r.primaryPacketMraysPerSecond
+            << ", \"ms_per_frame\": " << r.msPerFrameMean
+            << ", \"ms_per_frame_min\": " << r.msPerFrameMin
+            << ", \"mrays_per_s\": " << r.mraysPerSecond
+            << ", \"avg_path_length\": " << r.averagePathLength
+            << ", \"peak_rss_mb\": " << r.peakResidentMB;
+#if RT_ENABLE_STATS
+        out << ", \"nodes_per_ray\": " << r.counters.PerRay(StatCounter::NodeVisits)
+            << ", \"box_tests_per_ray\": " << r.counters.PerRay(StatCounter::AABBTests)
+            << ", \"triangle_tests_per_ray\": " << r.counters.PerRay(StatCounter::TriangleTests)
+            << ", \"sphere_tests_per_ray\": " << r.counters.PerRay(StatCounter::SphereTests);
+#endif
+        if (!r.scaling.empty()) {
+            out << ", \"scaling\": [";
+            for (size_t j = 0; j < r.scaling.size(); j++) {
+                const ScalingPoint& point = r.scaling[j];
+                out << (j > 0 ? ", " : "") << "{ \"threads\": " << point.threads
+                    << ", \"ms_per_frame\": " << point.msPerFrame
+                    << ", \"mrays_per_s\": " << point.mraysPerSecond
+                    << ", \"speedup\": " << Speedup(r.scaling[0], point) << " }";
+            }
+            out << "]";
+        }
+    }
+    out << " }";
+}
+
+void PrintResult(const BenchResult& result) {
+    if (!result.ok) return;
+    std::cout << result.name << ": " << result.msPerFrameMean << " ms/frame, " << result.mraysPerSecond
+              << " Mrays/s, BVH " << result.buildMs << " ms, peak RSS " << result.peakResidentMB << " MB" << std::endl;
+    for (const ScalingPoint& point : result.scaling) {
+        std::cout << "  " << point.threads << " threads: " << point.msPerFrame << " ms/frame, "
+                  << point.mraysPerSecond << " Mrays/s, speedup " << Speedup(result.scaling[0], point)
+                  << std::endl;
+    }
+}
+
+// JSON object of one scene run, and whether it succeeded
+struct SceneOutput {
+    std::string json;
+    bool ok = false;
+};
+
+SceneOutput RunSceneInProcess(const BenchScene& scene, const BenchSettings& settings, int threadCount) {
+    ThreadPool pool(threadCount);
+    BenchResult result = RunScene(scene, settings, pool);
+    PrintResult(result);
+    std::ostringstream json;
+    WriteSceneJSON(json, result);
+    return SceneOutput{ json.str(), result.ok };
+}
+
+// Peak RSS is a process-wide high-water mark, so each scene runs in a child process of its own and
+// reports only its own memory. The child sends its JSON object back through a pipe.
+SceneOutput RunSceneIsolated(const BenchScene& scene, const BenchSettings& settings, int threadCount) {
+#if defined(_WIN32)
+    return RunSceneInProcess(scene, settings, threadCount);
+#else
+    SceneOutput failed{ "{ \"name\": \"" + scene.name + "\", \"ok\": false }", false };
+    int fds[2];
+    if (pipe(fds) != 0) return failed;
+    // Buffered output would otherwise be written by both processes
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return failed;
+    }
+    if (child == 0) {
+        close(fds[0]);
+        SceneOutput output = RunSceneInProcess(scene, settings, threadCount);
+        std::cout.flush();
+        size_t written = 0;
+        while (written < output.json.size()) {
+            ssize_t n = write(fds[1], output.json.data() + written, output.json.size() - written);
+            if (n <= 0) _exit(1);
+            written += size_t(n);
+        }
+        close(fds[1]);
+        _exit(output.ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    std::string json;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) json.append(buffer, size_t(n));
+    close(fds[0]);
+    int status = 0;
+    if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || json.empty()) {
+        std::cerr << "Scene " << scene.name << " did not finish" << std::endl;
+        return failed;
+    }
+    return SceneOutput{ json, WEXITSTATUS(status) == 0 };
+#endif
+}
+
+void WriteJSON(std::ostream& out, const BenchSettings& settings, int threadCount, const std::vector<SceneOutput>& results) {
+    out << "{\n";
+    out << "  \"settings\": { \"width\": " << settings.width << ", \"height\": " << settings.height
+        << ", \"spp\": " << settings.samplesPerPixel << ", \"depth\": " << settings.maxDepth
+        << ", \"frames\": " << settings.frames << ", \"threads\": " << threadCount
+        << ", \"simd\": \"" << SimdLevelName(ActiveSimdLevel()) << "\" },\n";
+    out << "  \"scenes\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        out << "    " << results[i].json << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+bool ParseSettings(int argc, char* argv[], BenchSettings& settings) {
+    for (int i = 1; i < argc; i++) {
+        std::string name = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << name << std::endl;
+            return false;
+        }
+        const char* text = argv[++i];
+        int* intValue = nullptr;
+        double minimum = 1.0;
+        if (name == "--width") intValue = &settings.width;
+        else if (name == "--height") intValue = &settings.height;
+        else if (name == "--spp") intValue = &settings.samplesPerPixel;
+        else if (name == "--depth") intValue = &settings.maxDepth;
+        else if (name == "--frames") intValue = &settings.frames;
+        else if (name == "--threads") { intValue = &settings.threadCount; minimum = 0.0; }
+        else if (name == "--scaling") { intValue = &settings.scalingThreads; minimum = 0.0; }
+        else if (name == "--models") settings.modelsPath = text;
+        else if (name == "--output") settings.outputPath = text;
+        else if (name == "--scene") settings.only = text;
+        else {
+            std::cerr << "Unknown option " << name << std::endl;
+            return false;
+        }
+
+        // Same checks as the headless renderer's command line
+        double value;
+        if (intValue) {
+            if (!ParseNumberArgument(name.c_str(), text, minimum, double(std::numeric_limits<int>::max()), value)) return false;
+            *intValue = static_cast<int>(value);
+        }
+    }
+    return true;
+}
+}
+
+int main(int argc, char* argv[]) {
+    BenchSettings settings;
+    if (!ParseSettings(argc, argv, settings)) {
+        std::cerr << "Usage: PathTracingRenderer_bench [--width N] [--height N] [--spp N] [--depth N] [--frames N]"
+                  << " [--threads N] [--scaling MAX_THREADS] [--models DIR] [--scene NAME] [--output FILE]" << std::endl;
+        return 1;
+    }
+
+    int threadCount = settings.threadCount > 0 ? settings.threadCount : int(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<SceneOutput> results;
+    for (const BenchScene& scene : CanonicalScenes(settings)) {
+        if (!settings.only.empty() && scene.name != settings.only) continue;
+        results.push_back(RunSceneIsolated(scene, settings, threadCount));
+    }
+
+    std::ofstream file(settings.outputPath);
+    if (!file) {
+        std::cerr << "Cannot open file: " << settings.outputPath << std::endl;
+        return 1;
+    }
+    WriteJSON(file, settings, threadCount, results);
+    std::cout << "Results written to " << settings.outputPath << std::endl;
+
+    bool allOk = std::all_of(results.begin(), results.end(), [](const SceneOutput& r) { return r.ok; });
+    return allOk ? 0 : 1;
+}
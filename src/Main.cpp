@@ -1,6 +1,7 @@
 #include "core/Vec3.h"
 #include "core/Ray.h"
 #include "scene/Scene.h"
+#include "scene/SceneSnapshot.h"
 #include "geometry/Sphere.h"
 #include "geometry/Plane.h"
 #include "geometry/Cylinder.h"
@@ -9,6 +10,11 @@
 #include "scene/Camera.h"
 #include "geometry/Transform.h"
 #include "renderer/Renderer.h"
+#include "renderer/WavefrontIntegrator.h"
+#include "renderer/SamplerComparison.h"
+#include "renderer/TileScheduler.h"
+#include "renderer/PixelAccumulator.h"
+#include "renderer/BatchRender.h"
 #include "utils/Image.h"
 #include "materials/Lambertian.h"
 #include "materials/Metal.h"
@@ -25,7 +31,11 @@
 #include <thread>
 #include <vector>
 #include <mutex>
+#include <string>
+#include <future>
+#include <chrono>
 #include "utils/ThreadPool.h"
+#include "utils/RenderStats.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -39,12 +49,11 @@ Renderer renderer;
 Image* image = nullptr;
 std::vector<uint32_t> cpuFB;
 ThreadPool* threadPool = nullptr;
-std::vector<RenderTask> renderTasks;
+TileScheduler tileScheduler;
 SDL_Window* sdlWindow = nullptr;
 SDL_Renderer* sdlRenderer = nullptr;
 SDL_Texture* sdlTexture = nullptr;
-std::vector<Vec3> accumulationBuffer;
-int accumulatedFrames = 0;
+PixelAccumulator accumulation;
 bool cameraMoving = true;
 Vec3 lastCameraPosition;
 Vec3 lastCameraForward;
@@ -63,45 +72,111 @@ struct {
 Uint64 lastTime;
 float deltaTime = 0.0f;
 bool isRunning = true;
+// 'f' switches between the per-pixel renderer and the wavefront integrator
+bool useWavefront = false;
+WavefrontIntegrator wavefront;
+std::vector<Vec3> wavefrontColors;
+
+// Displayed ARGB pixels, top row first, rows pitch pixels apart: cpuFB or the memory of a locked texture
+struct FrameTarget {
+    uint32_t* pixels;
+    int pitch;
+};
+
+// Adds the pixel to the accumulation while the camera is still and writes the displayed color to image and target.
+// Retired pixels were not traced, so they show their converged mean.
+void WritePixel(int i, int j, const Vec3& pixelColor, PixelAccumulator& accumulation, bool cameraMoving,
+    const FrameTarget& target)
+{
+    size_t pixelIndex = size_t(j) * imageWidth + i;
+
+    Vec3 finalColor;
+    if (cameraMoving) {
+        finalColor = pixelColor;
+    } else if (accumulation.IsRetired(pixelIndex)) {
+        finalColor = accumulation.Mean(pixelIndex);
+    } else {
+        finalColor = accumulation.Add(pixelIndex, pixelColor);
+    }
+
+    image->SetPixel(i, j, finalColor);
+    #ifdef __EMSCRIPTEN__
+    // For SDL2, use a simpler approach to pack RGB values
+    uint8_t r = static_cast<uint8_t>(std::min(finalColor.x, 1.0f) * 255);
+    uint8_t g = static_cast<uint8_t>(std::min(finalColor.y, 1.0f) * 255);
+    uint8_t b = static_cast<uint8_t>(std::min(finalColor.z, 1.0f) * 255);
+    target.pixels[(imageHeight - j - 1) * target.pitch + i] = (0xFF << 24) | (r << 16) | (g << 8) | b;
+    #else
+    target.pixels[(imageHeight - j - 1) * target.pitch + i] = SDL_MapRGBA(SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_ARGB8888),
+        nullptr, static_cast<uint8_t>(std::min(finalColor.x, 1.0f) * 255),
+        static_cast<uint8_t>(std::min(finalColor.y, 1.0f) * 255),
+        static_cast<uint8_t>(std::min(finalColor.z, 1.0f) * 255),
+        255);
+    #endif
+}
 
-void RenderRows(int startRow, int endRow, const int imageWidth, const int imageHeight, 
-    const int samplesPerPixel, const int maxDepth, const Camera& camera, const Scene& scene, 
-    const Renderer& renderer, Image& image, std::vector<uint32_t>& cpuFB) 
+// Renders one scheduler tile: in packetSize x packetSize packets in packet mode, in one piece otherwise
+void RenderImageTile(const ImageTile& tile, const Camera& camera, const Scene& scene, const Renderer& renderer,
+    PixelAccumulator& accumulation, bool cameraMoving, const FrameTarget& target)
 {
-    int totalRows = endRow - startRow;
+    // While the camera is still, converged pixels are skipped
+    const uint8_t* retired = cameraMoving ? nullptr : accumulation.RetiredMask();
+    int step = renderer.packetSize > 0 ? renderer.packetSize : std::max(tile.width, tile.height);
+    thread_local std::vector<Vec3> tileColors;
+    tileColors.resize(size_t(tile.width) * tile.height);
 
-    for (int j = startRow; j > endRow; --j) 
+    for (int y0 = tile.y0; y0 < tile.y0 + tile.height; y0 += step)
     {
-        for (int i = 0; i < imageWidth; ++i) 
+        int rows = std::min(step, tile.y0 + tile.height - y0);
+        for (int x0 = tile.x0; x0 < tile.x0 + tile.width; x0 += step)
         {
-            Vec3 pixelColor(0, 0, 0);
-            for (int s = 0; s < samplesPerPixel; ++s) 
+            int columns = std::min(step, tile.x0 + tile.width - x0);
+            renderer.RenderTile(camera, scene, x0, y0, columns, rows, imageWidth, imageHeight,
+                samplesPerPixel, maxDepth, tileColors.data(), retired);
+
+            for (int y = 0; y < rows; ++y)
             {
-                float u = (i + RandomFloat()) / (imageWidth - 1);
-                float v = (j + RandomFloat()) / (imageHeight - 1);
-                Ray ray = camera.GetRay(u, v);
-                pixelColor += renderer.TraceRay(ray, scene, maxDepth);
+                for (int x = 0; x < columns; ++x)
+                {
+                    WritePixel(x0 + x, y0 + y, tileColors[y * columns + x], accumulation, cameraMoving, target);
+                }
             }
-            // Average the color and write to image
-             pixelColor /= float(samplesPerPixel);
-             image.SetPixel(i, j, pixelColor);
-             #ifdef __EMSCRIPTEN__
-             // For SDL2, use a simpler approach to pack RGB values
-             uint8_t r = static_cast<uint8_t>(std::min(pixelColor.x, 1.0f) * 255);
-             uint8_t g = static_cast<uint8_t>(std::min(pixelColor.y, 1.0f) * 255);
-             uint8_t b = static_cast<uint8_t>(std::min(pixelColor.z, 1.0f) * 255);
-             cpuFB[(imageHeight - j - 1) * imageWidth + i] = (0xFF << 24) | (r << 16) | (g << 8) | b;
-             #else
-             cpuFB[(imageHeight - j - 1) * imageWidth + i] = SDL_MapRGBA(SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_ARGB8888),
-                 nullptr, static_cast<uint8_t>(std::min(pixelColor.x, 1.0f) * 255),
-                 static_cast<uint8_t>(std::min(pixelColor.y, 1.0f) * 255),
-                 static_cast<uint8_t>(std::min(pixelColor.z, 1.0f) * 255),
-                 255);
-             #endif
         }
     }
 }
 
+// Renders the whole frame with the wavefront integrator, whose stages run on the pool (inline when it is null)
+void RenderWavefront(const Camera& camera, const Scene& scene, PixelAccumulator& accumulation, bool cameraMoving,
+    const FrameTarget& target, ThreadPool* pool)
+{
+    wavefront.Render(camera, scene, imageWidth, imageHeight, samplesPerPixel, maxDepth, wavefrontColors, pool);
+    for (int j = 0; j < imageHeight; ++j)
+    {
+        for (int i = 0; i < imageWidth; ++i)
+        {
+            WritePixel(i, j, wavefrontColors[j * imageWidth + i], accumulation, cameraMoving, target);
+        }
+    }
+}
+
+// Average rays per path in the last frame; restarts the renderer's count for the next one
+double LastFramePathLength(const Renderer& renderer)
+{
+    double pathLength = useWavefront ? wavefront.AveragePathLength() : renderer.AveragePathLength();
+    renderer.ResetPathStats();
+    return pathLength;
+}
+
+// Ray and traversal counters of the frames traced since the last call
+std::string LastFrameRenderStats()
+{
+    static RenderStats previous;
+    RenderStats total = CollectRenderStats();
+    std::string summary = FormatRenderStats(total - previous);
+    previous = total;
+    return summary;
+}
+
 // Function to be called each frame
 void main_loop() {
     Uint64 currentTime = SDL_GetPerformanceCounter();
@@ -110,13 +185,20 @@ void main_loop() {
     lastTime = currentTime;
     float fps = 1.0f / deltaTime;
     
+    accumulation.UpdateStats();
     #ifdef __EMSCRIPTEN__
     // For web, just print to console
     if ((int)(currentTime / frequency) % 60 == 0) { // Print every 60 frames
-        std::cout << "FPS: " << fps << std::endl;
+        std::cout << "FPS: " << fps << ", avg path length: " << LastFramePathLength(renderer)
+            << ", " << tileScheduler.TileSize() << "px tile imbalance: " << tileScheduler.LastStats().Imbalance()
+            << ", active pixels: " << 100.0 * accumulation.ActiveFraction() << "%"
+            << ", " << LastFrameRenderStats() << std::endl;
     }
     #else
-    std::cout << "\rFPS: " << fps << "   \r" << std::flush;
+    std::cout << "\rFPS: " << fps << ", avg path length: " << LastFramePathLength(renderer)
+        << ", " << tileScheduler.TileSize() << "px tile imbalance: " << tileScheduler.LastStats().Imbalance()
+        << ", active pixels: " << 100.0 * accumulation.ActiveFraction() << "%"
+        << ", " << LastFrameRenderStats() << "   \r" << std::flush;
     #endif
 
     SDL_Event event;
@@ -156,6 +238,15 @@ void main_loop() {
                 case SDLK_LSHIFT:
                     keyState.shift_pressed = true;
                     break;
+                case 'p':
+                    renderer.packetSize = renderer.packetSize > 0 ? 0 : 4;
+                    break;
+                case 'f':
+                    useWavefront = !useWavefront;
+                    break;
+                case 't':
+                    tileScheduler.Build(imageWidth, imageHeight, tileScheduler.TileSize() >= 64 ? 8 : tileScheduler.TileSize() * 2);
+                    break;
             }
         #ifdef __EMSCRIPTEN__
         } else if (event.type == SDL_KEYUP) {
@@ -207,69 +298,24 @@ void main_loop() {
     lastCameraForward = camera.GetForward();
 
     if (!cameraMoving && currentlyMoving) {
-        std::fill(accumulationBuffer.begin(), accumulationBuffer.end(), Vec3(0,0,0));
-        accumulatedFrames = 0;
+        accumulation.Reset();
     }
     cameraMoving = currentlyMoving;
-    if (!cameraMoving) accumulatedFrames++;
     
     // Render the scene
-    auto renderLambda = [&](const RenderTask& task) {
-        for (int j = task.startRow; j > task.endRow; --j) 
-        {
-            for (int i = 0; i < imageWidth; ++i) 
-            {
-                Vec3 pixelColor(0, 0, 0);
-                for (int s = 0; s < samplesPerPixel; ++s) 
-                {
-                    float u = (i + RandomFloat()) / (imageWidth - 1);
-                    float v = (j + RandomFloat()) / (imageHeight - 1);
-                    Ray ray = camera.GetRay(u, v);
-                    pixelColor += renderer.TraceRay(ray, scene, maxDepth);
-                }
-
-                int pixelIndex = j * imageWidth + i;
-
-                // Average the color and write to image
-                 pixelColor /= float(samplesPerPixel);
-
-                 if (!cameraMoving) {
-                    accumulationBuffer[pixelIndex] += pixelColor;
-                 }
-
-                 Vec3 finalColor;
-                 if (accumulatedFrames > 0) {
-                    finalColor = accumulationBuffer[pixelIndex] / float(accumulatedFrames);
-                 } else {
-                    finalColor = pixelColor;
-                 }
-
-                 image->SetPixel(i, j, finalColor);
-                 #ifdef __EMSCRIPTEN__
-                 // For SDL2, use a simpler approach to pack RGB values
-                 uint8_t r = static_cast<uint8_t>(std::min(finalColor.x, 1.0f) * 255);
-                 uint8_t g = static_cast<uint8_t>(std::min(finalColor.y, 1.0f) * 255);
-                 uint8_t b = static_cast<uint8_t>(std::min(finalColor.z, 1.0f) * 255);
-                 cpuFB[(imageHeight - j - 1) * imageWidth + i] = (0xFF << 24) | (r << 16) | (g << 8) | b;
-                 #else
-                 cpuFB[(imageHeight - j - 1) * imageWidth + i] = SDL_MapRGBA(SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_ARGB8888),
-                     nullptr, static_cast<uint8_t>(std::min(finalColor.x, 1.0f) * 255),
-                     static_cast<uint8_t>(std::min(finalColor.y, 1.0f) * 255),
-                     static_cast<uint8_t>(std::min(finalColor.z, 1.0f) * 255),
-                     255);
-                 #endif
-            }
-        }
+    FrameTarget target{ cpuFB.data(), imageWidth };
+    auto renderLambda = [&](const ImageTile& tile) {
+        RenderImageTile(tile, camera, scene, renderer, accumulation, cameraMoving, target);
     };
     
-    #ifdef __EMSCRIPTEN__
-    // Single-threaded rendering for web
-    for (const auto& task : renderTasks) {
-        renderLambda(task);
+    renderer.frameIndex++;
+    wavefront.frameIndex = renderer.frameIndex;
+    if (useWavefront) {
+        RenderWavefront(camera, scene, accumulation, cameraMoving, target, threadPool);
+    } else {
+        // threadPool is null on the web, where tiles are rendered on the main thread
+        tileScheduler.Run(threadPool, renderLambda);
     }
-    #else
-    threadPool->SubmitAndWait(renderTasks, renderLambda);
-    #endif
     
     SDL_UpdateTexture(sdlTexture, nullptr, cpuFB.data(), imageWidth * int(sizeof(uint32_t)));
     SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255);
@@ -284,76 +330,54 @@ void main_loop() {
     lastTime = currentTime;
 }
 
-int main() {
-    // Initialize constants
-    imageWidth = 400;
-    imageHeight = 225;
-    #ifdef __EMSCRIPTEN__
-    samplesPerPixel = 2; // Lower for web performance
-    maxDepth = 3;        // Lower for web performance
-    #else
-    samplesPerPixel = 4;
-    maxDepth = 4;
-    #endif
-    
-    // Initialize image and frame buffer
-    image = new Image(imageWidth, imageHeight);
-    cpuFB.resize(imageWidth * imageHeight);
-    
-    // Initialize scene with spheres
-    Scene scene;
-    
+void BuildDemoScene(Scene& scene) {
     auto groundMaterial = std::make_shared<Lambertian>(Vec3(0.8f, 0.8f, 0.0f));
     auto centerMaterial = std::make_shared<Lambertian>(Vec3(0.7f, 0.3f, 0.3f));
     auto cylinderMaterial = std::make_shared<Metal>(Vec3(0.2f, 0.2f, 0.4f));
     auto glassMaterial = std::make_shared<Dielectric>(1.05f);
     auto emissiveMaterial = std::make_shared<Emissive>(Vec3(1.0f, 1.0f, 1.0f), 1.0f);
 
-    auto sphere = std::make_shared<Sphere>(glassMaterial);
+    auto sphere = std::make_shared<Sphere>(scene.AddMaterial(glassMaterial));
     auto transformedSphere = std::make_shared<Transform>(sphere);
     transformedSphere->SetPosition(Vec3(0, 0, -1));
     transformedSphere->SetRotation(Vec3(0, 0, 0));
     transformedSphere->SetScale(Vec3(0.25f, 0.5f, 0.5f));
 
-    auto cube = std::make_shared<Sphere>(glassMaterial);
+    auto cube = std::make_shared<Sphere>(scene.AddMaterial(glassMaterial));
     auto transformedCube = std::make_shared<Transform>(cube);
     transformedCube->SetPosition(Vec3(1.25f, -0.5f, -2));
     transformedCube->SetRotation(Vec3(0, 45, 45));
     transformedCube->SetScale(Vec3(0.5f, 0.5f, 0.5f));
 
-    auto plane = std::make_shared<Plane>(cylinderMaterial);
+    auto plane = std::make_shared<Plane>(scene.AddMaterial(cylinderMaterial));
     auto transformedPlane = std::make_shared<Transform>(plane);
     transformedPlane->SetPosition(Vec3(0, -1.2f, -5));
     transformedPlane->SetRotation(Vec3(0, 0, 0));
     transformedPlane->SetScale(Vec3(5, 5, 5));
-    auto cube2 = std::make_shared<Cube>(groundMaterial);
+    auto cube2 = std::make_shared<Cube>(scene.AddMaterial(groundMaterial));
     auto transformedCube2 = std::make_shared<Transform>(cube2);
     transformedCube2->SetPosition(Vec3(0, -0.5f, -3));
     transformedCube2->SetRotation(Vec3(0, 0, 0));
     transformedCube2->SetScale(Vec3(5.0f, 5.0f, 1.0f));
 
-    auto cube3 = std::make_shared<Cube>(groundMaterial);
+    auto cube3 = std::make_shared<Cube>(scene.AddMaterial(groundMaterial));
     auto transformedCube3 = std::make_shared<Transform>(cube3);
     transformedCube3->SetPosition(Vec3(1.2f, 0, -1));
     transformedCube3->SetRotation(Vec3(0, 0, 0));
     transformedCube3->SetScale(Vec3(1.0f, 5.0f, 5.0f));
 
-    auto cylinder = std::make_shared<Cylinder>(cylinderMaterial);
+    auto cylinder = std::make_shared<Cylinder>(scene.AddMaterial(cylinderMaterial));
     auto transformedCylinder = std::make_shared<Transform>(cylinder);
     transformedCylinder->SetPosition(Vec3(0, -0.75f, -2.0f));
     transformedCylinder->SetRotation(Vec3(0, 0, 0));
     transformedCylinder->SetScale(Vec3(0.5f, 0.5f, 0.5f));
 
     auto customMeshMaterial = std::make_shared<Metal>(Vec3(0.5f, 0.5f, 0.9f));
-    auto customMesh = std::make_shared<Mesh>(groundMaterial);
+    auto customMesh = std::make_shared<Mesh>(scene.AddMaterial(groundMaterial));
     #ifndef __EMSCRIPTEN__
     // Only load mesh on desktop for now
     if (customMesh->LoadFromOBJ("models/monkey.obj")) {
-        auto transformedMesh = std::make_shared<Transform>(customMesh);
-        transformedMesh->SetPosition(Vec3(0, -0.75, -2));
-        transformedMesh->SetRotation(Vec3(0, 30, 0));
-        transformedMesh->SetScale(Vec3(0.5f, 0.5f, 0.5f));
-        scene.Add(transformedMesh);
+        scene.AddInstance(customMesh, Vec3(0, -0.75, -2), Vec3(0, 30, 0), Vec3(0.5f, 0.5f, 0.5f));
     }
     #endif
 
@@ -372,12 +396,86 @@ int main() {
     scene.Add(transformedPlane);
     scene.BuildBVH();
     //scene.Add(transformedCylinder);
+}
+
+int main(int argc, char* argv[]) {
+    // Initialize constants
+    imageWidth = 400;
+    imageHeight = 225;
+    #ifdef __EMSCRIPTEN__
+    samplesPerPixel = 2; // Lower for web performance
+    maxDepth = 3;        // Lower for web performance
+    #else
+    samplesPerPixel = 4;
+    maxDepth = 8;        // Russian roulette keeps the deeper limit cheap
+    #endif
+    
+    // Initialize image and frame buffer
+    image = new Image(imageWidth, imageHeight);
+    cpuFB.resize(imageWidth * imageHeight);
+    
+    // Initialize scene with spheres
+    Scene scene;
+    
+    #ifndef __EMSCRIPTEN__
+    // --load-scene PATH replaces the demo scene with a snapshot (meshes and BVHs prebuilt);
+    // --save-scene PATH writes the scene out after it is set up
+    std::string loadScenePath;
+    std::string saveScenePath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--load-scene") loadScenePath = argv[i + 1];
+        if (std::string(argv[i]) == "--save-scene") saveScenePath = argv[i + 1];
+    }
+    if (!loadScenePath.empty()) {
+        auto loadStart = std::chrono::steady_clock::now();
+        if (!LoadSceneSnapshot(loadScenePath, scene)) return 1;
+        if (!scene.IsBVHBuilt()) scene.BuildBVH();
+        std::cout << "Scene ready in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count()
+                  << " ms" << std::endl;
+    } else {
+        BuildDemoScene(scene);
+    }
+    if (!saveScenePath.empty() && !SaveSceneSnapshot(scene, saveScenePath)) return 1;
+    #else
+    BuildDemoScene(scene);
+    #endif
     
     // Create camera
     Camera camera;
     
-    // Create renderer
+    // Create renderer; primary rays are traced as 4x4 packets, bounces as single rays ('p' toggles)
     Renderer renderer;
+    renderer.packetSize = 4;
+    renderer.sampler = CreateSampler(SamplerType::Sobol, samplesPerPixel);
+    wavefront.sampler = renderer.sampler;
+
+    #ifndef __EMSCRIPTEN__
+    // --compare-samplers prints the RMSE-vs-spp table of every sampler and exits.
+    // --headless renders to a file without ever initializing SDL, e.g.
+    //   --headless --width 1920 --height 1080 --spp 256 --depth 8 --time 60 --output frame.ppm
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--compare-samplers") {
+            ThreadPool comparisonPool(std::max(1u, std::thread::hardware_concurrency()));
+            CompareSamplers(camera, scene, 160, 90, maxDepth, 64, 1024, &comparisonPool);
+            return 0;
+        }
+        if (std::string(argv[i]) == "--headless") {
+            BatchRenderOptions options;
+            options.samplesPerPass = samplesPerPixel;
+            options.maxDepth = maxDepth;
+            if (!ParseBatchRenderOptions(argc, argv, options)) return 1;
+            camera.SetAspectRatio(float(options.width) / options.height);
+            BatchRenderStats stats = RenderBatch(camera, scene, renderer, options);
+            PrintBatchRenderStats(options, stats);
+            return stats.saved ? 0 : 1;
+        }
+    }
+    #endif
+
+    PrimaryRayThroughput throughput = renderer.MeasurePrimaryThroughput(camera, scene, imageWidth, imageHeight, 4);
+    std::cout << "Primary rays: " << throughput.singleRaysPerSecond / 1e6 << " Mrays/s single, "
+              << throughput.packetRaysPerSecond / 1e6 << " Mrays/s in packets" << std::endl;
 
     // Initialize SDL
     #ifndef __EMSCRIPTEN__
@@ -437,85 +535,25 @@ int main() {
     ThreadPool threadPool(numThread);
     #endif
 
-    int rowsPerThread = imageHeight / numThread;
-    int remainingRows = imageHeight % numThread;
-    std::vector<RenderTask> renderTasks;
-
-    int currentRow = imageHeight - 1;
+    // Workers pull 16x16 tiles in Morton order ('t' cycles the tile size)
+    tileScheduler.Build(imageWidth, imageHeight, 16);
 
-    for (unsigned int t = 0; t < numThread; ++t) 
-    {
-        int startRow = currentRow;
-        int endRow = currentRow - rowsPerThread;
-        if (t == numThread - 1) 
-        {
-            endRow -= remainingRows; // Last thread takes the remaining rows
-        }
-        renderTasks.emplace_back(RenderTask{ startRow, endRow });
-        currentRow = endRow;
-    }
-
-    std::vector<Vec3> accumulationBuffer(imageWidth * imageHeight, Vec3(0,0,0));
-    int accumulatedFrames = 0;
+    // Per-pixel running mean and variance; pixels whose error falls under 2% stop receiving samples
+    PixelAccumulator accumulation(size_t(imageWidth) * imageHeight);
     bool cameraMoving = true;
     Vec3 lastCameraPosition = camera.GetPosition();
     Vec3 lastCameraForward = camera.GetForward();
 
-    auto renderFunction = [&](const RenderTask& task) {
-        for (int j = task.startRow; j > task.endRow; --j) 
-        {
-            for (int i = 0; i < imageWidth; ++i) 
-            {
-                Vec3 pixelColor(0, 0, 0);
-                for (int s = 0; s < samplesPerPixel; ++s) 
-                {
-                    float u = (i + RandomFloat()) / (imageWidth - 1);
-                    float v = (j + RandomFloat()) / (imageHeight - 1);
-                    Ray ray = camera.GetRay(u, v);
-                    pixelColor += renderer.TraceRay(ray, scene, maxDepth);
-                }
-
-                int pixelIndex = j * imageWidth + i;
-
-                // Average the color and write to image
-                 pixelColor /= float(samplesPerPixel);
-
-                 if (!cameraMoving) {
-                    accumulationBuffer[pixelIndex] += pixelColor;
-                 }
-
-                 Vec3 finalColor;
-                 if (accumulatedFrames > 0) {
-                    finalColor = accumulationBuffer[pixelIndex] / float(accumulatedFrames);
-                 } else {
-                    finalColor = pixelColor;
-                 }
-
-                 image->SetPixel(i, j, finalColor);
-                 #ifdef __EMSCRIPTEN__
-                 // For SDL2, use a simpler approach to pack RGB values
-                 uint8_t r = static_cast<uint8_t>(std::min(finalColor.x, 1.0f) * 255);
-                 uint8_t g = static_cast<uint8_t>(std::min(finalColor.y, 1.0f) * 255);
-                 uint8_t b = static_cast<uint8_t>(std::min(finalColor.z, 1.0f) * 255);
-                 cpuFB[(imageHeight - j - 1) * imageWidth + i] = (0xFF << 24) | (r << 16) | (g << 8) | b;
-                 #else
-                 cpuFB[(imageHeight - j - 1) * imageWidth + i] = SDL_MapRGBA(SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_ARGB8888),
-                     nullptr, static_cast<uint8_t>(std::min(finalColor.x, 1.0f) * 255),
-                     static_cast<uint8_t>(std::min(finalColor.y, 1.0f) * 255),
-                     static_cast<uint8_t>(std::min(finalColor.z, 1.0f) * 255),
-                     255);
-                 #endif
-            }
-        }
+    FrameTarget initialTarget{ cpuFB.data(), imageWidth };
+    auto renderFunction = [&](const ImageTile& tile) {
+        RenderImageTile(tile, camera, scene, renderer, accumulation, cameraMoving, initialTarget);
     };
 
     #ifdef __EMSCRIPTEN__
     // Single-threaded rendering for web
-    for (const auto& task : renderTasks) {
-        renderFunction(task);
-    }
+    tileScheduler.Run(nullptr, renderFunction);
     #else
-    threadPool.SubmitAndWait(renderTasks, renderFunction);
+    tileScheduler.Run(&threadPool, renderFunction);
     #endif
     
     // Save the rendered image
@@ -545,14 +583,12 @@ int main() {
     ::scene = scene;
     ::camera = camera;
     ::renderer = renderer;
-    ::accumulationBuffer = accumulationBuffer;
-    ::accumulatedFrames = accumulatedFrames;
+    ::accumulation = accumulation;
     ::cameraMoving = cameraMoving;
     ::lastCameraForward = lastCameraForward;
     ::sdlWindow = sdlWindow;
     ::sdlRenderer = sdlRenderer;
     ::sdlTexture = sdlTexture;
-    ::renderTasks = renderTasks;
     #ifndef __EMSCRIPTEN__
     ::threadPool = &threadPool;
     #endif
@@ -566,13 +602,72 @@ int main() {
     );
     emscripten_set_main_loop(main_loop, 0, 1);
     #else
-    // Regular desktop main loop
+    // Regular desktop main loop. Frames are traced on their own thread straight into the memory of a
+    // locked streaming texture, while this thread keeps handling input and showing the other texture;
+    // the two swap roles whenever a frame finishes.
+    SDL_Texture* frameTextures[2] = { sdlTexture,
+        SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, imageWidth, imageHeight) };
+    int displayedTexture = 0;
+    std::future<void> frameInFlight;
+    Uint64 lastFrameTime = lastTime;
+
+    // Keys pressed while a frame is in flight take effect with the next frame
+    int nextPacketSize = renderer.packetSize;
+    int nextTileSize = tileScheduler.TileSize();
+    bool nextUseWavefront = useWavefront;
+
+    // Captures the camera and accumulation state and starts tracing the next frame into the hidden texture
+    auto startFrame = [&]() {
+        bool currentlyMoving = keyState.w_pressed || keyState.s_pressed || keyState.a_pressed || keyState.d_pressed || keyState.space_pressed || keyState.shift_pressed || camera.GetForward() != lastCameraForward;
+
+        lastCameraForward = camera.GetForward();
+
+        if (!cameraMoving && currentlyMoving) {
+            accumulation.Reset();
+        }
+        cameraMoving = currentlyMoving;
+
+        renderer.packetSize = nextPacketSize;
+        useWavefront = nextUseWavefront;
+        tileScheduler.Build(imageWidth, imageHeight, nextTileSize);
+        renderer.frameIndex++;
+        wavefront.frameIndex = renderer.frameIndex;
+
+        void* pixels = nullptr;
+        int pitch = 0;
+        if (!SDL_LockTexture(frameTextures[1 - displayedTexture], nullptr, &pixels, &pitch)) {
+            SDL_Log("Unable to lock frame texture: %s", SDL_GetError());
+            isRunning = false;
+            return;
+        }
+        FrameTarget target{ static_cast<uint32_t*>(pixels), pitch / int(sizeof(uint32_t)) };
+        Camera frameCamera = camera;
+        bool frameMoving = cameraMoving;
+
+        frameInFlight = std::async(std::launch::async, [&, target, frameCamera, frameMoving]() {
+            if (useWavefront) {
+                RenderWavefront(frameCamera, scene, accumulation, frameMoving, target, &threadPool);
+            } else {
+                tileScheduler.Run(&threadPool, [&](const ImageTile& tile) {
+                    RenderImageTile(tile, frameCamera, scene, renderer, accumulation, frameMoving, target);
+                });
+            }
+        });
+    };
+
+    auto present = [&]() {
+        SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255);
+        SDL_RenderClear(sdlRenderer);
+        SDL_RenderTexture(sdlRenderer, frameTextures[displayedTexture], nullptr, nullptr);
+        SDL_RenderPresent(sdlRenderer);
+    };
+
+    present();
+    startFrame();
     while (isRunning) {
         Uint64 currentTime = SDL_GetPerformanceCounter();
         deltaTime = (float)(currentTime - lastTime) / (float)frequency;
         lastTime = currentTime;
-        float fps = 1.0f / deltaTime;
-        std::cout<<"\rFPS: " << fps << "   \r" << std::flush;
 
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
@@ -607,6 +702,15 @@ int main() {
                     case SDLK_LSHIFT:
                         keyState.shift_pressed = true;
                         break;
+                    case 'p':
+                        nextPacketSize = nextPacketSize > 0 ? 0 : 4;
+                        break;
+                    case 'f':
+                        nextUseWavefront = !nextUseWavefront;
+                        break;
+                    case 't':
+                        nextTileSize = nextTileSize >= 64 ? 8 : nextTileSize * 2;
+                        break;
                 }
             #ifdef __EMSCRIPTEN__
             } else if (event.type == SDL_KEYUP) {
@@ -653,35 +757,35 @@ int main() {
         if (keyState.space_pressed) camera.MoveUp(0.5f * deltaTime);
         if (keyState.shift_pressed) camera.MoveUp(-0.5f * deltaTime);
 
-        bool currentlyMoving = keyState.w_pressed || keyState.s_pressed || keyState.a_pressed || keyState.d_pressed || keyState.space_pressed || keyState.shift_pressed || camera.GetForward() != lastCameraForward;
+        if (!frameInFlight.valid() || frameInFlight.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            // Keep polling input at a steady rate while the frame is traced
+            SDL_Delay(1);
+            continue;
+        }
 
-        lastCameraForward = camera.GetForward();
+        // Show the finished frame and start tracing the next one right away
+        frameInFlight.get();
+        displayedTexture = 1 - displayedTexture;
+        SDL_UnlockTexture(frameTextures[displayedTexture]);
+
+        float fps = (float)frequency / (float)(currentTime - lastFrameTime);
+        lastFrameTime = currentTime;
+        accumulation.UpdateStats();
+        std::cout<<"\rFPS: " << fps << ", avg path length: " << LastFramePathLength(renderer)
+            << ", " << tileScheduler.TileSize() << "px tile imbalance: " << tileScheduler.LastStats().Imbalance()
+            << ", active pixels: " << 100.0 * accumulation.ActiveFraction() << "%"
+            << ", " << LastFrameRenderStats() << "   \r" << std::flush;
+
+        if (isRunning) startFrame();
+        present();
+    }
 
-        if (!cameraMoving && currentlyMoving) {
-            std::fill(accumulationBuffer.begin(), accumulationBuffer.end(), Vec3(0,0,0));
-            accumulatedFrames = 0;
-        }
-        cameraMoving = currentlyMoving;
-        if (!cameraMoving) accumulatedFrames++;
-        
-        #ifdef __EMSCRIPTEN__
-        // Single-threaded rendering for web
-        for (const auto& task : renderTasks) {
-            renderFunction(task);
-        }
-        #else
-        threadPool.SubmitAndWait(renderTasks, renderFunction);
-        #endif
-        SDL_UpdateTexture(sdlTexture, nullptr, cpuFB.data(), imageWidth * int(sizeof(uint32_t)));
-        SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255);
-        SDL_RenderClear(sdlRenderer);
-        #ifdef __EMSCRIPTEN__
-        SDL_RenderCopy(sdlRenderer, sdlTexture, nullptr, nullptr);
-        #else
-        SDL_RenderTexture(sdlRenderer, sdlTexture, nullptr, nullptr);
-        #endif
-        SDL_RenderPresent(sdlRenderer);
+    // The frame in flight still writes into its texture and reads the scene
+    if (frameInFlight.valid()) {
+        frameInFlight.wait();
+        SDL_UnlockTexture(frameTextures[1 - displayedTexture]);
     }
+    SDL_DestroyTexture(frameTextures[1]);
     
     // Desktop cleanup
     SDL_DestroyTexture(sdlTexture);
@@ -701,8 +805,7 @@ extern "C" {
         samplesPerPixel = samples;
         maxDepth = depth;
         // Reset accumulation when quality changes
-        std::fill(accumulationBuffer.begin(), accumulationBuffer.end(), Vec3(0,0,0));
-        accumulatedFrames = 0;
+        accumulation.Reset();
     }
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "core/AffineTransform.h"
+
+AffineTransform::AffineTransform() {
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            columns[col][row] = (row == col && row < 3) ? 1.0f : 0.0f;
+        }
+    }
+}
+
+AffineTransform AffineTransform::Compose(const Vec3& position, const Vec3& rotation, const Vec3& scale) {
+    return FromMatrix(Matrix4x4::Translation(position) * Matrix4x4::Rotation(rotation) * Matrix4x4::Scaling(scale));
+}
+
+AffineTransform AffineTransform::FromMatrix(const Matrix4x4& matrix) {
+    AffineTransform result;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++) {
+            result(row, col) = matrix(row, col);
+        }
+    }
+    return result;
+}
+
+AffineTransform AffineTransform::operator*(const AffineTransform& other) const {
+    AffineTransform result;
+    for (int col = 0; col < 3; col++) {
+        Vec3 column = TransformDirection(Vec3(other(0, col), other(1, col), other(2, col)));
+        result(0, col) = column.x;
+        result(1, col) = column.y;
+        result(2, col) = column.z;
+    }
+    Vec3 translation = TransformPoint(Vec3(other(0, 3), other(1, 3), other(2, 3)));
+    result(0, 3) = translation.x;
+    result(1, 3) = translation.y;
+    result(2, 3) = translation.z;
+    return result;
+}
+
+AffineTransform AffineTransform::Inverse() const {
+    const AffineTransform& a = *this;
+    // Adjugate of the 3x3 linear part, row by row
+    float c00 = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+    float c01 = a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2);
+    float c02 = a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1);
+    float c10 = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+    float c11 = a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0);
+    float c12 = a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2);
+    float c20 = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+    float c21 = a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1);
+    float c22 = a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+
+    float det = a(0, 0) * c00 + a(0, 1) * c10 + a(0, 2) * c20;
+    // Singular maps (a zero scale) have no inverse; like Matrix4x4::Inverse, fall back to identity
+    if (det == 0.0f) return Identity();
+    float invDet = 1.0f / det;
+
+    AffineTransform inverse;
+    float adjugate[3][3] = { { c00, c01, c02 }, { c10, c11, c12 }, { c20, c21, c22 } };
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            inverse(row, col) = adjugate[row][col] * invDet;
+        }
+    }
+    // Inverse translation: -A^-1 t
+    Vec3 translation = inverse.TransformDirection(Vec3(a(0, 3), a(1, 3), a(2, 3)));
+    inverse(0, 3) = -translation.x;
+    inverse(1, 3) = -translation.y;
+    inverse(2, 3) = -translation.z;
+    return inverse;
+}
+
+float AffineTransform::Determinant() const {
+    const AffineTransform& a = *this;
+    return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1))
+         - a(0, 1) * (a(1, 0) * a(2, 2) - a(1, 2) * a(2, 0))
+         + a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+}
+
+AffineTransform AffineTransform::LinearTranspose() const {
+    AffineTransform result;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            result(row, col) = (*this)(col, row);
+        }
+    }
+    return result;
+}
+
+Matrix4x4 AffineTransform::ToMatrix() const {
+    Matrix4x4 result;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++) {
+            result(row, col) = (*this)(row, col);
+        }
+    }
+    return result;
+}
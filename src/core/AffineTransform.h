@@ -0,0 +1,97 @@
+#pragma once
+#include "core/Vec3.h"
+#include "core/Vec3A.h"
+#include "core/Ray.h"
+#include "core/Matrix4x4.h"
+#include "core/Simd.h"
+
+// Affine map p' = A p + t, the top three rows of a 4x4 matrix whose last row is (0, 0, 0, 1). Stored by
+// column, each padded to four floats, so a point is three broadcast multiply-adds on SSE. There is no
+// perspective divide and the inverse needs only a 3x3 adjugate.
+class alignas(16) AffineTransform {
+private:
+    float columns[4][4]; // columns[3] is the translation; lane 3 is always zero
+public:
+    AffineTransform();
+
+    static AffineTransform Identity() { return AffineTransform(); }
+    // Translation * rotation (Euler angles in degrees, as Matrix4x4::Rotation) * scale
+    static AffineTransform Compose(const Vec3& position, const Vec3& rotation, const Vec3& scale);
+    // Top three rows of matrix; the bottom row is assumed to be (0, 0, 0, 1)
+    static AffineTransform FromMatrix(const Matrix4x4& matrix);
+
+    AffineTransform operator*(const AffineTransform& other) const;
+    AffineTransform Inverse() const;
+    // Determinant of the linear part; zero when a scale is zero and the map has no inverse
+    float Determinant() const;
+    // Transposed linear part without translation; the inverse's is the normal matrix
+    AffineTransform LinearTranspose() const;
+    Matrix4x4 ToMatrix() const;
+
+    float operator()(int row, int col) const { return columns[col][row]; }
+    float& operator()(int row, int col) { return columns[col][row]; }
+
+    Vec3A TransformPoint(const Vec3A& point) const {
+#if defined(RT_SIMD_X86)
+        __m128 result = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_load_ps(columns[0]), _mm_set1_ps(point.x)),
+                _mm_mul_ps(_mm_load_ps(columns[1]), _mm_set1_ps(point.y))),
+            _mm_add_ps(_mm_mul_ps(_mm_load_ps(columns[2]), _mm_set1_ps(point.z)), _mm_load_ps(columns[3])));
+        return ToVec3A(result);
+#else
+        return Vec3A(
+            columns[0][0] * point.x + columns[1][0] * point.y + columns[2][0] * point.z + columns[3][0],
+            columns[0][1] * point.x + columns[1][1] * point.y + columns[2][1] * point.z + columns[3][1],
+            columns[0][2] * point.x + columns[1][2] * point.y + columns[2][2] * point.z + columns[3][2]);
+#endif
+    }
+
+    Vec3A TransformDirection(const Vec3A& direction) const {
+#if defined(RT_SIMD_X86)
+        __m128 result = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_load_ps(columns[0]), _mm_set1_ps(direction.x)),
+                _mm_mul_ps(_mm_load_ps(columns[1]), _mm_set1_ps(direction.y))),
+            _mm_mul_ps(_mm_load_ps(columns[2]), _mm_set1_ps(direction.z)));
+        return ToVec3A(result);
+#else
+        return Vec3A(
+            columns[0][0] * direction.x + columns[1][0] * direction.y + columns[2][0] * direction.z,
+            columns[0][1] * direction.x + columns[1][1] * direction.y + columns[2][1] * direction.z,
+            columns[0][2] * direction.x + columns[1][2] * direction.y + columns[2][2] * direction.z);
+#endif
+    }
+
+    // The direction is left unnormalized, so a hit at parameter t on the result is at t on ray as well
+    Ray TransformRay(const Ray& ray) const {
+        Ray result;
+        result.origin = TransformPoint(ray.origin);
+        result.direction = TransformDirection(ray.direction);
+        return result;
+    }
+
+private:
+#if defined(RT_SIMD_X86)
+    // Lane 3 of every column is zero, so the result's padding lane is as well
+    static Vec3A ToVec3A(__m128 value) {
+        Vec3A result;
+        _mm_store_ps(&result.x, value);
+        return result;
+    }
+#endif
+};
+
+// Placement of an object with both directions and the normal matrix precomputed, so a hit costs two
+// ray-transform passes and a normal transform, with no inverse or transpose per hit
+struct ObjectTransform {
+    AffineTransform objectToWorld;
+    AffineTransform worldToObject;
+    AffineTransform normalToWorld;
+
+    ObjectTransform() = default;
+    explicit ObjectTransform(const AffineTransform& toWorld)
+        : objectToWorld(toWorld), worldToObject(toWorld.Inverse()), normalToWorld(worldToObject.LinearTranspose()) {}
+
+    Ray ToObject(const Ray& ray) const { return worldToObject.TransformRay(ray); }
+    Vec3A PointToWorld(const Vec3A& point) const { return objectToWorld.TransformPoint(point); }
+    Vec3A NormalToWorld(const Vec3A& normal) const { return normalToWorld.TransformDirection(normal).Normalize(); }
+};
@@ -0,0 +1,47 @@
+#include "core/Random.h"
+#include "core/Simd.h"
+
+#if defined(RT_SIMD_X86)
+namespace {
+RT_TARGET_AVX2
+__m256i HashUInt32x8(__m256i x) {
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846ca68bu)));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    return x;
+}
+
+RT_TARGET_AVX2
+size_t FillAVX2(const RandomStream& stream, uint32_t first, float* out, size_t count) {
+    const __m256i key0 = _mm256_set1_epi32(static_cast<int>(stream.key0));
+    const __m256i key1 = _mm256_set1_epi32(static_cast<int>(stream.key1));
+    const __m256 scale = _mm256_set1_ps(1.0f / 16777216.0f);
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(first)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = HashUInt32x8(_mm256_add_epi32(HashUInt32x8(_mm256_xor_si256(index, key0)), key1));
+        // Values below 2^24 convert exactly, matching RandomStream::ToFloat
+        __m256 result = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(value, 8)), scale);
+        _mm256_storeu_ps(out + i, result);
+        index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+    }
+    return i;
+}
+}
+#endif
+
+void RandomStream::Fill(float* out, size_t count) {
+    size_t i = 0;
+#if defined(RT_SIMD_X86)
+    if (ActiveSimdLevel() == SimdLevel::AVX2) {
+        i = FillAVX2(*this, counter, out, count);
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = ToFloat(Generate(counter + static_cast<uint32_t>(i)));
+    }
+    counter += static_cast<uint32_t>(count);
+}
@@ -1,15 +1,60 @@
 #pragma once
 #include "core/Vec3.h"
-#include <random>
+#include <cstdint>
+#include <cstddef>
+
+// 32-bit integer hash (Wellons' lowbias32); a bijection with strong avalanche
+inline uint32_t HashUInt32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Counter-based generator: value n of a stream is a hash of n and the stream key, so a stream
+// seeded from (pixel, frame, sample) yields the same numbers whichever thread draws them,
+// and any value can be computed directly without stepping through the ones before it
+class RandomStream {
+public:
+    uint32_t key0 = 0;
+    uint32_t key1 = 0;
+    uint32_t counter = 0;
+
+    RandomStream() = default;
+    RandomStream(uint32_t pixel, uint32_t frame, uint32_t sample) { Seed(pixel, frame, sample); }
+
+    void Seed(uint32_t pixel, uint32_t frame, uint32_t sample) {
+        key0 = HashUInt32(pixel ^ HashUInt32(frame + 0x9e3779b9u));
+        key1 = HashUInt32(sample ^ HashUInt32(key0 + 0x632be5abu));
+        counter = 0;
+    }
+
+    uint32_t Generate(uint32_t index) const { return HashUInt32(HashUInt32(index ^ key0) + key1); }
+    static float ToFloat(uint32_t value) { return (value >> 8) * (1.0f / 16777216.0f); }
+
+    uint32_t NextUInt() { return Generate(counter++); }
+    // Uniform in [0, 1)
+    float NextFloat() { return ToFloat(NextUInt()); }
+    // Same values as count calls to NextFloat, computed eight at a time with AVX2
+    void Fill(float* out, size_t count);
+};
+
+// Stream behind RandomFloat and friends on the calling thread; renderers reseed it for every path
+inline RandomStream& ThreadRandomStream() {
+    thread_local RandomStream stream;
+    return stream;
+}
 
 inline float RandomFloat() {
-    static std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
-    static std::mt19937 generator;
-    return distribution(generator);
+    return ThreadRandomStream().NextFloat();
 }
 
+// Uniform in [min, max]
 inline int RandomInt(int min, int max) {
-    return min + rand() % (max - min + 1);
+    uint32_t range = static_cast<uint32_t>(max - min) + 1u;
+    return min + static_cast<int>((uint64_t(ThreadRandomStream().NextUInt()) * range) >> 32);
 }
 
 inline Vec3 RandomInUnitSphere() {
@@ -26,4 +71,4 @@ inline Vec3 RandomInUnitSphere() {
 
 inline Vec3 RandomUnitVector() {
     return RandomInUnitSphere().Normalize();
-}
\ No newline at end of file
+}
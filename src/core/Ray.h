@@ -1,17 +1,18 @@
 #pragma once
 #include "core/Vec3.h"
+#include "core/Vec3A.h"
 
 
 class Ray {
 public:
-    Vec3 origin;
-    Vec3 direction;
+    Vec3A origin;
+    Vec3A direction;
 
-    Ray() : origin(Vec3()), direction(Vec3(0, 1, 0)) {}
-    Ray(const Vec3& origin, const Vec3& direction)
+    Ray() : origin(Vec3A()), direction(Vec3A(0, 1, 0)) {}
+    Ray(const Vec3A& origin, const Vec3A& direction)
         : origin(origin), direction(direction.Normalize()) {}
 
-    Vec3 At(float t) const {
+    Vec3A At(float t) const {
         return origin + direction * t;
     }
 };
@@ -0,0 +1,206 @@
+#define _USE_MATH_DEFINES
+#include "core/Sampler.h"
+#include "core/Random.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+uint32_t HashCombine(uint32_t seed, uint32_t value) {
+    return HashUInt32(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+uint32_t PixelSeed(uint32_t x, uint32_t y) {
+    return HashCombine(HashUInt32(x), y);
+}
+
+float ToUnitFloat(uint32_t value) {
+    return (value >> 8) * (1.0f / 16777216.0f);
+}
+
+uint32_t ReverseBits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+
+// Laine-Karras style hash that only propagates bits upwards
+uint32_t LaineKarrasPermutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Owen scrambling of the bits of x, most significant bit first
+uint32_t NestedUniformScramble(uint32_t x, uint32_t seed) {
+    return ReverseBits(LaineKarrasPermutation(ReverseBits(x), seed));
+}
+
+// Random permutation of [0, length) (Kensler, "Correlated Multi-Jittered Sampling")
+uint32_t Permute(uint32_t i, uint32_t length, uint32_t seed) {
+    uint32_t w = length - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    do {
+        i ^= seed;
+        i *= 0xe170893du;
+        i ^= seed >> 16;
+        i ^= (i & w) >> 4;
+        i ^= seed >> 8;
+        i *= 0x0929eb3fu;
+        i ^= seed >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1u | seed >> 27;
+        i *= 0x6935fa69u;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303u;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3u;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3dfu;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= length);
+    return (i + seed) % length;
+}
+
+// Sobol dimensions used directly; higher dimensions are padded with independently scrambled copies
+// of these, so every pair of dimensions handed out for a 2D sample is a (0, 2)-sequence
+constexpr uint32_t kSobolDimensions = 2;
+
+// Direction numbers: van der Corput, then the primitive polynomial x + 1 with m = 1 (Joe and Kuo)
+struct SobolDirections {
+    uint32_t v[kSobolDimensions][32];
+
+    SobolDirections() {
+        uint32_t m = 1;
+        for (int k = 0; k < 32; k++) {
+            v[0][k] = 1u << (31 - k);
+            v[1][k] = m << (31 - k);
+            m ^= m << 1;
+        }
+    }
+};
+
+uint32_t Sobol(uint32_t index, uint32_t dimension) {
+    static const SobolDirections directions;
+    uint32_t result = 0;
+    for (int k = 0; index; index >>= 1, k++) {
+        if (index & 1u) result ^= directions.v[dimension][k];
+    }
+    return result;
+}
+
+// Owen-scrambled Sobol value: the index is shuffled, then the output is scrambled per dimension
+float ScrambledSobol(uint32_t index, uint32_t dimension, uint32_t seed) {
+    uint32_t group = dimension / kSobolDimensions;
+    uint32_t groupSeed = HashCombine(seed, group);
+    index = NestedUniformScramble(index, groupSeed);
+    uint32_t result = Sobol(index, dimension % kSobolDimensions);
+    return ToUnitFloat(NestedUniformScramble(result, HashCombine(groupSeed, dimension + 1)));
+}
+
+uint32_t MortonCode(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t v) {
+        v &= 0xffffu;
+        v = (v | (v << 8)) & 0x00ff00ffu;
+        v = (v | (v << 4)) & 0x0f0f0f0fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+}
+
+float IndependentSampler::Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const {
+    return ToUnitFloat(HashCombine(HashCombine(PixelSeed(x, y), sample), dimension));
+}
+
+float StratifiedSampler::Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const {
+    // Sample indices past the stratum count start a new, independently shuffled set of strata
+    uint32_t seed = HashCombine(HashCombine(PixelSeed(x, y), dimension), sample / strata);
+    uint32_t stratum = Permute(sample % strata, strata, seed);
+    float jitter = ToUnitFloat(HashCombine(seed, sample));
+    return (stratum + jitter) / strata;
+}
+
+float SobolSampler::Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const {
+    return ScrambledSobol(sample, dimension, PixelSeed(x, y));
+}
+
+BlueNoiseSampler::BlueNoiseSampler(int samplesPerPixel) : sampleBits(0) {
+    while (sampleBits < 16 && (1 << sampleBits) < samplesPerPixel) sampleBits++;
+}
+
+float BlueNoiseSampler::Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const {
+    // Samples past the block of one frame continue with a fresh scramble
+    uint32_t pass = sample >> sampleBits;
+    uint32_t seed = HashCombine(0x5bd1e995u, pass);
+    uint32_t group = dimension / kSobolDimensions;
+
+    // Shuffle the four quadrants at every level of the Morton tree, keyed by the path from the root
+    uint32_t morton = MortonCode(x, y);
+    uint32_t shuffled = 0;
+    for (int level = 15; level >= 0; level--) {
+        uint32_t prefix = level < 15 ? morton >> (2 * level + 2) : 0;
+        uint32_t digit = (morton >> (2 * level)) & 3u;
+        digit ^= HashCombine(HashCombine(seed, group), prefix * 16 + level) & 3u;
+        shuffled |= digit << (2 * level);
+    }
+
+    uint32_t index = (shuffled << sampleBits) | (sample & ((1u << sampleBits) - 1u));
+    uint32_t groupSeed = HashCombine(seed, group);
+    uint32_t result = Sobol(index, dimension % kSobolDimensions);
+    return ToUnitFloat(NestedUniformScramble(result, HashCombine(groupSeed, dimension + 1)));
+}
+
+std::shared_ptr<Sampler> CreateSampler(SamplerType type, int samplesPerPixel) {
+    switch (type) {
+        case SamplerType::Stratified:
+            return std::make_shared<StratifiedSampler>(samplesPerPixel);
+        case SamplerType::Sobol:
+            return std::make_shared<SobolSampler>();
+        case SamplerType::BlueNoise:
+            return std::make_shared<BlueNoiseSampler>(samplesPerPixel);
+        default:
+            return std::make_shared<IndependentSampler>();
+    }
+}
+
+const char* SamplerTypeName(SamplerType type) {
+    switch (type) {
+        case SamplerType::Stratified: return "stratified";
+        case SamplerType::Sobol: return "sobol";
+        case SamplerType::BlueNoise: return "blue-noise";
+        default: return "independent";
+    }
+}
+
+float SamplerContext::Next1D() {
+    if (!sampler) return RandomFloat();
+    return sampler->Get(x, y, sample, dimension++);
+}
+
+Vec3A SampleCosineHemisphere(const Vec3A& normal, float u, float v) {
+    // Orthonormal basis around the normal (Duff et al. 2017)
+    float sign = std::copysign(1.0f, normal.z);
+    float a = -1.0f / (sign + normal.z);
+    float b = normal.x * normal.y * a;
+    Vec3A tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    Vec3A bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+
+    // Malley's method: uniform point on the unit disk projected up onto the hemisphere
+    float r = std::sqrt(u);
+    float phi = 2.0f * float(M_PI) * v;
+    float z = std::sqrt(std::max(0.0f, 1.0f - u));
+    return tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * z;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "core/Vec3.h"
+#include "core/Vec3A.h"
+#include <cstdint>
+#include <memory>
+
+enum class SamplerType {
+    Independent, // Hash of (pixel, sample, dimension); no stratification
+    Stratified,  // Shuffled jittered strata in every dimension
+    Sobol,       // Owen-scrambled Sobol sequence per pixel
+    BlueNoise    // One Owen-scrambled Sobol sequence walked in scrambled Morton order over the pixels
+};
+
+// Source of sample values addressed by pixel, sample index and dimension, so an integrator
+// gets the same value for the same (pixel, sample, dimension) on any thread
+class Sampler {
+public:
+    virtual ~Sampler() = default;
+
+    // Value in [0, 1)
+    virtual float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const = 0;
+    virtual SamplerType Type() const = 0;
+};
+
+class IndependentSampler : public Sampler {
+public:
+    virtual float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+    virtual SamplerType Type() const override { return SamplerType::Independent; }
+};
+
+// Each dimension places samplesPerPixel consecutive samples in distinct strata, in a shuffled order per pixel
+class StratifiedSampler : public Sampler {
+private:
+    uint32_t strata;
+public:
+    explicit StratifiedSampler(int samplesPerPixel) : strata(samplesPerPixel > 0 ? samplesPerPixel : 1) {}
+    virtual float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+    virtual SamplerType Type() const override { return SamplerType::Stratified; }
+};
+
+// Hash-based Owen scrambling of the Sobol sequence (Burley 2020), padded: each pair of dimensions
+// is the first two Sobol dimensions with its own shuffle and scramble
+class SobolSampler : public Sampler {
+public:
+    virtual float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+    virtual SamplerType Type() const override { return SamplerType::Sobol; }
+};
+
+// Pixels take consecutive blocks of one scrambled Sobol sequence in hierarchically shuffled Morton
+// order (Ahmed and Wonka 2020), so the error of neighboring pixels is spread as blue noise
+class BlueNoiseSampler : public Sampler {
+private:
+    uint32_t sampleBits; // log2 of samplesPerPixel rounded up
+public:
+    explicit BlueNoiseSampler(int samplesPerPixel);
+    virtual float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+    virtual SamplerType Type() const override { return SamplerType::BlueNoise; }
+};
+
+std::shared_ptr<Sampler> CreateSampler(SamplerType type, int samplesPerPixel);
+const char* SamplerTypeName(SamplerType type);
+
+// Dimension layout of a camera path: the pixel jitter, then a fixed block per bounce
+constexpr uint32_t kCameraSampleDimensions = 2;
+constexpr uint32_t kBounceSampleDimensions = 2;
+
+// Path being traced on this thread; materials draw their sample values through it
+struct SamplerContext {
+    const Sampler* sampler = nullptr; // Null falls back to RandomFloat
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t sample = 0;
+    uint32_t dimension = 0;
+
+    // Moves to the dimensions reserved for the given bounce (1 for the first hit)
+    void BeginBounce(int bounce) {
+        dimension = kCameraSampleDimensions + uint32_t(bounce - 1) * kBounceSampleDimensions;
+    }
+
+    // Value of the next dimension
+    float Next1D();
+    void Next2D(float& u, float& v) {
+        u = Next1D();
+        v = Next1D();
+    }
+};
+
+inline SamplerContext& ThreadSamplerContext() {
+    thread_local SamplerContext context;
+    return context;
+}
+
+// Next values of the path traced on this thread
+inline float SampleNext1D() {
+    return ThreadSamplerContext().Next1D();
+}
+inline void SampleNext2D(float& u, float& v) {
+    ThreadSamplerContext().Next2D(u, v);
+}
+
+// Cosine-weighted direction about the unit normal, from two sample values in closed form
+Vec3A SampleCosineHemisphere(const Vec3A& normal, float u, float v);
@@ -0,0 +1,65 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RT_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// AArch64 always has NEON, including the vector divide Vec3A needs
+#if !defined(RT_SIMD_X86) && defined(__ARM_NEON) && defined(__aarch64__)
+#define RT_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang need per-function target attributes to emit AVX2 code without -mavx2
+#if defined(RT_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RT_TARGET_AVX2
+#endif
+
+enum class SimdLevel {
+    Scalar,
+    SSE,
+    AVX2
+};
+
+// Highest instruction set the running CPU supports
+inline SimdLevel DetectSimdLevel() {
+#if defined(RT_SIMD_X86)
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    if (info[1] & (1 << 5)) return SimdLevel::AVX2;
+#endif
+    return SimdLevel::SSE;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// Level used by the SIMD kernels; may be lowered to compare code paths
+inline SimdLevel& ActiveSimdLevel() {
+    static SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+// Requests a level, clamped to what the CPU supports; returns the level now in use
+inline SimdLevel SetSimdLevel(SimdLevel level) {
+    SimdLevel detected = DetectSimdLevel();
+    ActiveSimdLevel() = static_cast<int>(level) < static_cast<int>(detected) ? level : detected;
+    return ActiveSimdLevel();
+}
+
+inline const char* SimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSE: return "SSE";
+        default: return "scalar";
+    }
+}
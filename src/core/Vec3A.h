@@ -0,0 +1,181 @@
+#pragma once
+#include "core/Vec3.h"
+#include "core/Simd.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <ostream>
+
+// Hot-path vector: four 16-byte aligned floats, so arithmetic is a single SSE or NEON operation on x, y, z
+// and a padding lane w. Unlike Vec3 nothing is checked in release builds; division by zero, normalizing a
+// zero vector and out-of-range indices are caught by asserts in debug builds only. Converts implicitly to
+// and from Vec3, which stays the type of the scene authoring API.
+class alignas(16) Vec3A {
+public:
+    float x, y, z;
+    float w; // Padding lane, zero unless a zero was divided by zero
+
+    Vec3A() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+    Vec3A(float x, float y, float z) : x(x), y(y), z(z), w(0.0f) {}
+    Vec3A(const Vec3& v) : x(v.x), y(v.y), z(v.z), w(0.0f) {}
+
+    operator Vec3() const { return Vec3(x, y, z); }
+
+    Vec3A Cross(const Vec3A& other) const {
+#if defined(RT_SIMD_X86)
+        __m128 a = Load();
+        __m128 b = other.Load();
+        __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+        __m128 bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+        return Store(_mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX)));
+#else
+        return Vec3A(
+            y * other.z - z * other.y,
+            z * other.x - x * other.z,
+            x * other.y - y * other.x
+        );
+#endif
+    }
+    // Summed in the same order as Vec3::Dot so both give identical results
+    float Dot(const Vec3A& other) const {
+        return x * other.x + y * other.y + z * other.z;
+    }
+    float Length() const {
+        return std::sqrt(LengthSquared());
+    }
+    float LengthSquared() const {
+        return x * x + y * y + z * z;
+    }
+    Vec3A Normalize() const {
+        float length = Length();
+        assert(length != 0.0f && "Cannot normalize zero-length vector");
+        return *this / length;
+    }
+
+    Vec3A Reflect(const Vec3A& normal) const {
+        return *this - normal * (2 * Dot(normal));
+    }
+
+    Vec3A Refract(const Vec3A& normal, float eta) const {
+        float cosTheta = std::fmin(((*this) * -1).Dot(normal), 1.0f);
+        Vec3A rOutPerp = (*this + normal * cosTheta) * eta;
+        Vec3A rOutParallel = normal * -std::sqrt(std::fabs(1.0f - rOutPerp.LengthSquared()));
+        return rOutPerp + rOutParallel;
+    }
+
+    // Per-component reciprocal, infinite for zero components as the slab tests expect
+    Vec3A Reciprocal() const {
+        return Vec3A(1.0f / x, 1.0f / y, 1.0f / z);
+    }
+
+    static Vec3A Min(const Vec3A& a, const Vec3A& b) {
+#if defined(RT_SIMD_X86)
+        return Store(_mm_min_ps(a.Load(), b.Load()));
+#elif defined(RT_SIMD_NEON)
+        return Store(vminq_f32(a.Load(), b.Load()));
+#else
+        return Vec3A(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+#endif
+    }
+    static Vec3A Max(const Vec3A& a, const Vec3A& b) {
+#if defined(RT_SIMD_X86)
+        return Store(_mm_max_ps(a.Load(), b.Load()));
+#elif defined(RT_SIMD_NEON)
+        return Store(vmaxq_f32(a.Load(), b.Load()));
+#else
+        return Vec3A(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+#endif
+    }
+
+    float MinComponent() const { return std::min(std::min(x, y), z); }
+    float MaxComponent() const { return std::max(std::max(x, y), z); }
+
+    Vec3A operator+(const Vec3A& other) const {
+#if defined(RT_SIMD_X86)
+        return Store(_mm_add_ps(Load(), other.Load()));
+#elif defined(RT_SIMD_NEON)
+        return Store(vaddq_f32(Load(), other.Load()));
+#else
+        return Vec3A(x + other.x, y + other.y, z + other.z);
+#endif
+    }
+    Vec3A operator-(const Vec3A& other) const {
+#if defined(RT_SIMD_X86)
+        return Store(_mm_sub_ps(Load(), other.Load()));
+#elif defined(RT_SIMD_NEON)
+        return Store(vsubq_f32(Load(), other.Load()));
+#else
+        return Vec3A(x - other.x, y - other.y, z - other.z);
+#endif
+    }
+    Vec3A operator*(float scalar) const {
+#if defined(RT_SIMD_X86)
+        return Store(_mm_mul_ps(Load(), _mm_set1_ps(scalar)));
+#elif defined(RT_SIMD_NEON)
+        return Store(vmulq_n_f32(Load(), scalar));
+#else
+        return Vec3A(x * scalar, y * scalar, z * scalar);
+#endif
+    }
+    Vec3A operator*(const Vec3A& other) const {
+#if defined(RT_SIMD_X86)
+        return Store(_mm_mul_ps(Load(), other.Load()));
+#elif defined(RT_SIMD_NEON)
+        return Store(vmulq_f32(Load(), other.Load()));
+#else
+        return Vec3A(x * other.x, y * other.y, z * other.z);
+#endif
+    }
+    Vec3A operator/(float scalar) const {
+        assert(scalar != 0.0f && "Division by zero");
+#if defined(RT_SIMD_X86)
+        return Store(_mm_div_ps(Load(), _mm_set1_ps(scalar)));
+#elif defined(RT_SIMD_NEON)
+        return Store(vdivq_f32(Load(), vdupq_n_f32(scalar)));
+#else
+        return Vec3A(x / scalar, y / scalar, z / scalar);
+#endif
+    }
+
+    bool operator==(const Vec3A& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+    bool operator!=(const Vec3A& other) const {
+        return !(*this == other);
+    }
+
+    Vec3A& operator+=(const Vec3A& other) { return *this = *this + other; }
+    Vec3A& operator-=(const Vec3A& other) { return *this = *this - other; }
+    Vec3A& operator*=(float scalar) { return *this = *this * scalar; }
+    Vec3A& operator/=(float scalar) { return *this = *this / scalar; }
+
+    float operator[](int index) const {
+        assert(index >= 0 && index < 3 && "Index out of range");
+        return (&x)[index];
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Vec3A& v) {
+        os << "(" << v.x << ", " << v.y << ", " << v.z << ")";
+        return os;
+    }
+
+private:
+#if defined(RT_SIMD_X86)
+    __m128 Load() const { return _mm_load_ps(&x); }
+    static Vec3A Store(__m128 lanes) {
+        Vec3A result;
+        _mm_store_ps(&result.x, lanes);
+        return result;
+    }
+#elif defined(RT_SIMD_NEON)
+    float32x4_t Load() const { return vld1q_f32(&x); }
+    static Vec3A Store(float32x4_t lanes) {
+        Vec3A result;
+        vst1q_f32(&result.x, lanes);
+        return result;
+    }
+#endif
+};
+static_assert(sizeof(Vec3A) == 16, "Vec3A must stay one 16-byte register");
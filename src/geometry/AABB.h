@@ -1,44 +1,54 @@
 #pragma once
 #include "core/Vec3.h"
+#include "core/Vec3A.h"
 #include "core/Ray.h"
+#include <algorithm>
+#include <cfloat>
 
 class AABB {
 public:
-    Vec3 min;
-    Vec3 max;
+    Vec3A min;
+    Vec3A max;
     
     AABB() {}
 
-    AABB(const Vec3& min, const Vec3& max) : min(min), max(max) {}
+    AABB(const Vec3A& min, const Vec3A& max) : min(min), max(max) {}
 
+    // Inverted box that any Expand call will replace
+    static AABB Empty() {
+        return AABB(Vec3(FLT_MAX, FLT_MAX, FLT_MAX), Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+    }
+
+    void Expand(const Vec3A& point) {
+        min = Vec3A::Min(min, point);
+        max = Vec3A::Max(max, point);
+    }
+
+    void Expand(const AABB& box) {
+        min = Vec3A::Min(min, box.min);
+        max = Vec3A::Max(max, box.max);
+    }
+
+    Vec3A Centroid() const {
+        return (min + max) * 0.5f;
+    }
+
+    float SurfaceArea() const {
+        Vec3A d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    // All three slabs at once: near and far distances per axis, then the tightest interval across axes
     bool Hit(const Ray& ray, float tMin, float tMax) const {
-        for (int a = 0; a < 3; a++) {
-            float invD = 1.0f / ray.direction[a];
-            float t0 = (min[a] - ray.origin[a]) * invD;
-            float t1 = (max[a] - ray.origin[a]) * invD;
-            if (invD < 0.0f) {
-                float temp = t0;
-                t0 = t1;
-                t1 = temp;
-            }
-            tMin = t0 > tMin ? t0 : tMin;
-            tMax = t1 < tMax ? t1 : tMax;
-            if (tMax <= tMin) return false;
-        }
-        return true;
+        Vec3A invDir = ray.direction.Reciprocal();
+        Vec3A t0 = (min - ray.origin) * invDir;
+        Vec3A t1 = (max - ray.origin) * invDir;
+        tMin = std::max(tMin, Vec3A::Min(t0, t1).MaxComponent());
+        tMax = std::min(tMax, Vec3A::Max(t0, t1).MinComponent());
+        return tMax > tMin;
     }
 
     static AABB SurroundingBox(const AABB& box0, const AABB& box1) {
-        Vec3 small(
-            std::min(box0.min.x, box1.min.x),
-            std::min(box0.min.y, box1.min.y),
-            std::min(box0.min.z, box1.min.z)
-        );
-        Vec3 big(
-            std::max(box0.max.x, box1.max.x),
-            std::max(box0.max.y, box1.max.y),
-            std::max(box0.max.z, box1.max.z)
-        );
-        return AABB(small, big);
+        return AABB(Vec3A::Min(box0.min, box1.min), Vec3A::Max(box0.max, box1.max));
     }
 };
\ No newline at end of file
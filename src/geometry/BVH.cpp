@@ -0,0 +1,37 @@
+#include "geometry/BVH.h"
+
+void BVH::Build(const std::vector<AABB>& primitiveBounds, const BVHBuildOptions& options) {
+    binary.Build(primitiveBounds, options);
+    wide4.Clear();
+    wide8.Clear();
+    SetLayout(options.layout);
+}
+
+void BVH::Build(std::vector<BVHPrimitive> prims, const BVHBuildOptions& options) {
+    binary.Build(std::move(prims), options);
+    wide4.Clear();
+    wide8.Clear();
+    SetLayout(options.layout);
+}
+
+void BVH::Assign(LinearBVH newBinary, BVHLayout newLayout) {
+    binary = std::move(newBinary);
+    wide4.Clear();
+    wide8.Clear();
+    SetLayout(newLayout);
+}
+
+void BVH::Clear() {
+    binary.Clear();
+    wide4.Clear();
+    wide8.Clear();
+}
+
+void BVH::SetLayout(BVHLayout newLayout) {
+    layout = newLayout;
+    if (layout == BVHLayout::Wide4 && wide4.Empty()) {
+        wide4.Build(binary);
+    } else if (layout == BVHLayout::Wide8 && wide8.Empty()) {
+        wide8.Build(binary);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "geometry/LinearBVH.h"
+#include "geometry/WideBVH.h"
+
+// Acceleration structure used by Scene and Mesh: always builds the binary
+// LinearBVH and, for the wide layouts, collapses it into a BVH4 or BVH8
+class BVH {
+private:
+    LinearBVH binary;
+    WideBVH<4> wide4;
+    WideBVH<8> wide8;
+    BVHLayout layout = BVHLayout::Binary;
+public:
+    void Build(const std::vector<AABB>& primitiveBounds, const BVHBuildOptions& options = BVHBuildOptions());
+    void Build(std::vector<BVHPrimitive> prims, const BVHBuildOptions& options = BVHBuildOptions());
+    // Builds the binary tree, then turns every leaf into one cluster (see LinearBVH::CollapseLeaves),
+    // so hitPrimitive receives cluster ids instead of primitive indices
+    template <typename MakeCluster>
+    void BuildClustered(std::vector<BVHPrimitive> prims, const BVHBuildOptions& options, MakeCluster&& makeCluster) {
+        binary.Build(std::move(prims), options);
+        binary.CollapseLeaves(makeCluster);
+        wide4.Clear();
+        wide8.Clear();
+        SetLayout(options.layout);
+    }
+    void Clear();
+    // Adopts a prebuilt binary tree; the wide layouts are collapsed from it without an SAH build
+    void Assign(LinearBVH newBinary, BVHLayout newLayout);
+
+    // Switches traversal layout without rebuilding the binary tree
+    void SetLayout(BVHLayout newLayout);
+    BVHLayout GetLayout() const { return layout; }
+
+    bool Empty() const { return binary.Empty(); }
+    bool BoundingBox(AABB& outputBox) const { return binary.BoundingBox(outputBox); }
+    float SAHCost() const { return binary.SAHCost(); }
+    size_t GetMemoryUsage() const { return binary.GetMemoryUsage() + wide4.GetMemoryUsage() + wide8.GetMemoryUsage(); }
+    const LinearBVH& GetBinary() const { return binary; }
+
+    template <typename HitPrimitive>
+    bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record, HitPrimitive&& hitPrimitive) const {
+        switch (layout) {
+            case BVHLayout::Wide4:
+                return wide4.Hit(ray, tMin, tMax, record, hitPrimitive);
+            case BVHLayout::Wide8:
+                return wide8.Hit(ray, tMin, tMax, record, hitPrimitive);
+            default:
+                return binary.Hit(ray, tMin, tMax, record, hitPrimitive);
+        }
+    }
+
+    // Packet traversal always walks the binary tree; see LinearBVH::HitPacket
+    template <typename VisitLeaf>
+    void HitPacket(RayPacket& packet, int firstRay, float tMin, VisitLeaf&& visitLeaf) const {
+        binary.HitPacket(packet, firstRay, tMin, visitLeaf);
+    }
+};
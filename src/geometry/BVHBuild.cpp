@@ -0,0 +1,134 @@
+#include "geometry/BVHBuild.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr int kMaxBVHBins = 64;
+
+struct BVHBin {
+    AABB bounds = AABB::Empty();
+    size_t count = 0;
+};
+
+int BinIndex(float centroid, float axisMin, float scale, int binCount) {
+    int bin = static_cast<int>((centroid - axisMin) * scale);
+    return std::min(std::max(bin, 0), binCount - 1);
+}
+
+size_t MedianSplit(BVHPrimitive* prims, size_t start, size_t end, int axis) {
+    size_t mid = start + (end - start) / 2;
+    std::nth_element(prims + start, prims + mid, prims + end,
+        [axis](const BVHPrimitive& a, const BVHPrimitive& b) {
+            return a.bounds.min[axis] < b.bounds.min[axis];
+        });
+    return mid;
+}
+}
+
+size_t SplitPrimitives(BVHPrimitive* prims, size_t start, size_t end, const AABB& bounds, int depth,
+    const BVHBuildOptions& options, int* splitAxis) {
+    size_t count = end - start;
+    // Leaf nodes store their primitive count in 16 bits
+    size_t maxLeafSize = static_cast<size_t>(std::min(std::max(1, options.maxLeafSize),
+        int(std::numeric_limits<uint16_t>::max())));
+    if (count <= 1) return end;
+
+    int remainingDepth = std::min(std::max(options.maxDepth, kMinBVHDepth), kMaxBVHDepth) - depth;
+    if (remainingDepth <= 0) return end;
+    // Halving keeps every range within 2^remainingDepth primitives, so once a child might not fit in
+    // its remaining levels the median split takes over from SAH and the depth limit is never reached
+    bool forceMedian = remainingDepth <= 32 && count > (size_t(1) << (remainingDepth - 1));
+
+    AABB centroidBounds = AABB::Empty();
+    for (size_t i = start; i < end; i++) {
+        centroidBounds.Expand(prims[i].centroid);
+    }
+
+    Vec3 extent = centroidBounds.max - centroidBounds.min;
+    int axis = 0;
+    if (extent.y > extent.x) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    if (splitAxis) *splitAxis = axis;
+
+    // All centroids coincide, so no plane can separate them
+    if (extent[axis] <= 0.0f) {
+        return count <= maxLeafSize ? end : start + count / 2;
+    }
+
+    if (options.splitMethod == BVHSplitMethod::Middle || forceMedian) {
+        return count <= maxLeafSize ? end : MedianSplit(prims, start, end, axis);
+    }
+
+    int binCount = std::min(std::max(options.binCount, 2), kMaxBVHBins);
+    BVHBin bins[3][kMaxBVHBins];
+    float rightCost[kMaxBVHBins];
+
+    float axisMin[3] = { centroidBounds.min.x, centroidBounds.min.y, centroidBounds.min.z };
+    float scale[3];
+    for (int a = 0; a < 3; a++) {
+        scale[a] = extent[a] > 0.0f ? binCount / extent[a] : 0.0f;
+    }
+
+    // Bin all three axes in a single pass over the primitives
+    for (size_t i = start; i < end; i++) {
+        const BVHPrimitive& prim = prims[i];
+        float centroid[3] = { prim.centroid.x, prim.centroid.y, prim.centroid.z };
+        for (int a = 0; a < 3; a++) {
+            BVHBin& bin = bins[a][BinIndex(centroid[a], axisMin[a], scale[a], binCount)];
+            bin.bounds.Expand(prim.bounds);
+            bin.count++;
+        }
+    }
+
+    float bestCost = std::numeric_limits<float>::infinity();
+    int bestAxis = -1;
+    int bestSplit = -1;
+
+    // Sweep the bin boundaries of every axis with non-zero centroid extent
+    for (int a = 0; a < 3; a++) {
+        if (extent[a] <= 0.0f) continue;
+
+        AABB rightBox = AABB::Empty();
+        size_t rightCount = 0;
+        for (int b = binCount - 1; b > 0; b--) {
+            rightBox.Expand(bins[a][b].bounds);
+            rightCount += bins[a][b].count;
+            rightCost[b - 1] = rightCount > 0 ? rightCount * rightBox.SurfaceArea() : 0.0f;
+        }
+
+        AABB leftBox = AABB::Empty();
+        size_t leftCount = 0;
+        for (int b = 0; b < binCount - 1; b++) {
+            leftBox.Expand(bins[a][b].bounds);
+            leftCount += bins[a][b].count;
+            if (leftCount == 0 || leftCount == count) continue;
+
+            float cost = leftCount * leftBox.SurfaceArea() + rightCost[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = a;
+                bestSplit = b;
+            }
+        }
+    }
+
+    if (bestAxis < 0) {
+        return count <= maxLeafSize ? end : MedianSplit(prims, start, end, axis);
+    }
+
+    float area = bounds.SurfaceArea();
+    float splitCost = kBVHTraversalCost + kBVHIntersectionCost * (area > 0.0f ? bestCost / area : 0.0f);
+    size_t packWidth = static_cast<size_t>(std::max(1, options.leafPackWidth));
+    float leafCost = kBVHIntersectionCost * ((count + packWidth - 1) / packWidth);
+    if (count <= maxLeafSize && splitCost >= leafCost) {
+        return end;
+    }
+
+    if (splitAxis) *splitAxis = bestAxis;
+
+    BVHPrimitive* mid = std::partition(prims + start, prims + end,
+        [&](const BVHPrimitive& prim) {
+            return BinIndex(prim.centroid[bestAxis], axisMin[bestAxis], scale[bestAxis], binCount) <= bestSplit;
+        });
+    return static_cast<size_t>(mid - prims);
+}
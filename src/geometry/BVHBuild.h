@@ -0,0 +1,65 @@
+#pragma once
+#include "geometry/AABB.h"
+#include "core/Simd.h"
+#include <cstdint>
+#include <cstddef>
+
+class ThreadPool;
+
+enum class BVHSplitMethod {
+    Middle, // Sort along the widest centroid axis and split at the object-count midpoint
+    SAH     // Binned surface area heuristic
+};
+
+enum class BVHLayout {
+    Binary, // LinearBVH with 32-byte nodes
+    Wide4,  // BVH4, children tested with one SSE slab test
+    Wide8   // BVH8, children tested with one AVX2 slab test (two SSE tests without AVX2)
+};
+
+// Wide nodes only pay off with a SIMD slab test, so scalar-only targets default to the binary tree
+#if defined(RT_SIMD_X86)
+constexpr BVHLayout kDefaultBVHLayout = BVHLayout::Wide8;
+#else
+constexpr BVHLayout kDefaultBVHLayout = BVHLayout::Binary;
+#endif
+
+// Entries in the explicit traversal stacks of LinearBVH and WideBVH. A leaf at depth d (root at 0) leaves
+// at most d pending siblings on the stack, and the packet walk pushes both children, so every tree no
+// deeper than kMaxBVHDepth fits.
+constexpr int kBVHTraversalStackSize = 64;
+constexpr int kMaxBVHDepth = kBVHTraversalStackSize - 1;
+// 32 levels of median splits reach single-primitive leaves for any 32-bit primitive count
+constexpr int kMinBVHDepth = 32;
+
+struct BVHBuildOptions {
+    BVHSplitMethod splitMethod = BVHSplitMethod::SAH;
+    int binCount = 16;
+    // Clamped to [1, 65535], as leaf nodes store their primitive count in 16 bits
+    int maxLeafSize = 4;
+    // Primitives intersected together by one leaf test (TrianglePack lanes); 1 means one test per primitive
+    int leafPackWidth = 1;
+    // Deepest leaf the builder may emit, clamped to [kMinBVHDepth, kMaxBVHDepth]. Ranges that could
+    // otherwise end up below it are split at the median instead of by SAH
+    int maxDepth = kMaxBVHDepth;
+    BVHLayout layout = kDefaultBVHLayout;
+    // Pool used to build large trees in parallel; a temporary one is created when null
+    ThreadPool* threadPool = nullptr;
+};
+
+// Relative costs used by the surface area heuristic
+constexpr float kBVHTraversalCost = 1.0f;
+constexpr float kBVHIntersectionCost = 1.0f;
+
+// Per-primitive data the builders work on, so objects are only queried for bounds once
+struct BVHPrimitive {
+    AABB bounds;
+    Vec3 centroid;
+    uint32_t index;
+};
+
+// Reorders prims[start, end) around the chosen split and returns the split position.
+// Returns end when the range should become a leaf. depth is the range's node depth (root at 0);
+// the split axis is written to splitAxis if given.
+size_t SplitPrimitives(BVHPrimitive* prims, size_t start, size_t end, const AABB& bounds, int depth,
+    const BVHBuildOptions& options, int* splitAxis = nullptr);
@@ -0,0 +1,84 @@
+#include "geometry/BVHNode.h"
+#include "utils/RenderStats.h"
+#include <iostream>
+
+BVHNode::BVHNode(const std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end,
+    const BVHBuildOptions& options) {
+    std::vector<BVHPrimitive> prims;
+    prims.reserve(end - start);
+
+    for (size_t i = start; i < end; i++) {
+        AABB objectBox;
+        if (!objects[i]->BoundingBox(objectBox)) {
+            std::cerr << "No bounding box in BVHNode constructor" << std::endl;
+            objectBox = AABB::Empty();
+        }
+        prims.push_back(BVHPrimitive{ objectBox, objectBox.Centroid(), static_cast<uint32_t>(i) });
+    }
+
+    *this = BVHNode(objects, prims, 0, prims.size(), 0, options);
+}
+
+BVHNode::BVHNode(const std::vector<std::shared_ptr<Hittable>>& objects, std::vector<BVHPrimitive>& prims,
+    size_t start, size_t end, int depth, const BVHBuildOptions& options) {
+    box = AABB::Empty();
+    for (size_t i = start; i < end; i++) {
+        box.Expand(prims[i].bounds);
+    }
+
+    size_t mid = SplitPrimitives(prims.data(), start, end, box, depth, options);
+
+    if (mid == start || mid == end) {
+        leafObjects.reserve(end - start);
+        for (size_t i = start; i < end; i++) {
+            leafObjects.push_back(objects[prims[i].index]);
+        }
+        return;
+    }
+
+    left = std::make_shared<BVHNode>(objects, prims, start, mid, depth + 1, options);
+    right = std::make_shared<BVHNode>(objects, prims, mid, end, depth + 1, options);
+}
+
+bool BVHNode::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    RT_STAT_INC(StatCounter::NodeVisits);
+    RT_STAT_INC(StatCounter::AABBTests);
+    if (!box.Hit(ray, tMin, tMax))
+        return false;
+
+    if (!leafObjects.empty()) {
+        bool hitAnything = false;
+        for (const auto& object : leafObjects) {
+            if (object->Hit(ray, tMin, tMax, record)) {
+                hitAnything = true;
+                tMax = record.t;
+            }
+        }
+        return hitAnything;
+    }
+
+    bool hitLeft = left->Hit(ray, tMin, tMax, record);
+    bool hitRight = right->Hit(ray, tMin, hitLeft ? record.t : tMax, record);
+
+    return hitLeft || hitRight;
+}
+
+bool BVHNode::BoundingBox(AABB& outputBox) const {
+    outputBox = box;
+    return true;
+}
+
+float BVHNode::SAHCost() const {
+    return SAHCost(box.SurfaceArea());
+}
+
+float BVHNode::SAHCost(float rootArea) const {
+    // Probability that a ray hitting the root also hits this node
+    float probability = rootArea > 0.0f ? box.SurfaceArea() / rootArea : 1.0f;
+
+    if (!leafObjects.empty()) {
+        return probability * kBVHIntersectionCost * leafObjects.size();
+    }
+
+    return probability * kBVHTraversalCost + left->SAHCost(rootArea) + right->SAHCost(rootArea);
+}
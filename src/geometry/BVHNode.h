@@ -1,122 +1,31 @@
 #pragma once
 #include "geometry/Hittable.h"
+#include "geometry/BVHBuild.h"
 #include <vector>
 #include <memory>
-#include <algorithm>
-#include "core/Random.h"
-#include <iostream>
 
 class BVHNode : public Hittable {
 private:
-    std::shared_ptr<Hittable> left;
-    std::shared_ptr<Hittable> right;
+    std::shared_ptr<BVHNode> left;
+    std::shared_ptr<BVHNode> right;
+    std::vector<std::shared_ptr<Hittable>> leafObjects;
     AABB box;
+
+    float SAHCost(float rootArea) const;
 public:
     BVHNode() {}
 
-    BVHNode(const std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end) {
-        auto objectList = objects;
-
-        AABB centroidBounds;
-        for (size_t i = start; i < end; i++) {
-            AABB box;
-            if (!objectList[i]->BoundingBox(box)) continue;
-            
-            Vec3 centroid = (box.min + box.max) * 0.5f;
-            if (i == start) {
-                centroidBounds = AABB(centroid, centroid);
-            } else {
-                centroidBounds = AABB(
-                    Vec3(
-                        std::min(centroidBounds.min.x, centroid.x),
-                        std::min(centroidBounds.min.y, centroid.y),
-                        std::min(centroidBounds.min.z, centroid.z)
-                    ),
-                    Vec3(
-                        std::max(centroidBounds.max.x, centroid.x),
-                        std::max(centroidBounds.max.y, centroid.y),
-                        std::max(centroidBounds.max.z, centroid.z)
-                    )
-                );
-            }
-        }
-        
-        Vec3 extent = centroidBounds.max - centroidBounds.min;
-        int axis = 0;
-        if (extent.y > extent.x) axis = 1;
-        if (extent.z > extent[axis]) axis = 2;
-
-        // Rest of your code remains similar
-        auto comparator = (axis == 0) ? BoxXCompare
-                        : (axis == 1) ? BoxYCompare
-                                    : BoxZCompare;
-
-        size_t objectSpan = end - start;
-
-        if (objectSpan == 1) {
-            left = right = objectList[start];
-        }
-        else if (objectSpan == 2) {
-            if (comparator(objectList[start], objectList[start + 1])) {
-                left = objectList[start];
-                right = objectList[start + 1];
-            }
-            else {
-                left = objectList[start + 1];
-                right = objectList[start];
-            }
-        }
-        else {
-            std::sort(objectList.begin() + start, objectList.begin() + end, comparator);
-
-            auto mid = start + objectSpan / 2;
-            left = std::make_shared<BVHNode>(objectList, start, mid);
-            right = std::make_shared<BVHNode>(objectList, mid, end);
-        }
-
-        AABB boxLeft, boxRight;
-
-        if (!left->BoundingBox(boxLeft) || !right->BoundingBox(boxRight)) {
-            std::cerr << "No bounding box in BVHNode constructor" << std::endl;
-        }
-
-        box = AABB::SurroundingBox(boxLeft, boxRight);
-    }
-
-    virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override {
-        if (!box.Hit(ray, tMin, tMax))
-            return false;
-
-        bool hitLeft = left->Hit(ray, tMin, tMax, record);
-        bool hitRight = right->Hit(ray, tMin, hitLeft ? record.t : tMax, record);
-
-        return hitLeft || hitRight;
-    }
-
-    virtual bool BoundingBox(AABB& outputBox) const override {
-        outputBox = box;
-        return true;
-    }
-
-    static bool BoxCompare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b, int axis) {
-        AABB boxA, boxB;
-
-        if (!a->BoundingBox(boxA) || !b->BoundingBox(boxB)) {
-            std::cerr << "No bounding box in BVHNode constructor" << std::endl;
-        }
+    BVHNode(const std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end,
+        const BVHBuildOptions& options = BVHBuildOptions());
 
-        return boxA.min[axis] < boxB.min[axis];
-    }
+    // Builds the subtree over prims[start, end) rooted at the given depth, reordering that range in place
+    BVHNode(const std::vector<std::shared_ptr<Hittable>>& objects, std::vector<BVHPrimitive>& prims,
+        size_t start, size_t end, int depth, const BVHBuildOptions& options);
 
-    static bool BoxXCompare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b) {
-        return BoxCompare(a, b, 0);
-    }
+    virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
 
-    static bool BoxYCompare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b) {
-        return BoxCompare(a, b, 1);
-    }
+    virtual bool BoundingBox(AABB& outputBox) const override;
 
-    static bool BoxZCompare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b) {
-        return BoxCompare(a, b, 2);
-    }
-};
\ No newline at end of file
+    // Expected cost of a ray query against this tree, used to compare builders
+    float SAHCost() const;
+};
@@ -1,7 +1,9 @@
 #include "geometry/Cube.h"
+#include "utils/RenderStats.h"
 #include <limits>
 
 bool Cube::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    RT_STAT_INC(StatCounter::OtherPrimitiveTests);
     Vec3 lowerBound = Vec3(-1, -1, -1);
     Vec3 upperBound = Vec3(1, 1, 1);
 
@@ -61,7 +63,7 @@ bool Cube::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const
     
     record.t = t;
     record.point = ray.At(t);
-    record.material = material;
+    record.materialId = materialId;
     
     // Determine the normal based on which face was hit
     const float epsilon = 1e-6f;
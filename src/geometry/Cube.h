@@ -3,12 +3,12 @@
 
 class Cube : public Hittable {
 public:
-    std::shared_ptr<Material> material;
+    uint32_t materialId;
 
-    Cube() : material(nullptr) {}
+    Cube() : materialId(kNoMaterial) {}
 
-    Cube(std::shared_ptr<Material> material)
-        : material(material) {}
+    Cube(uint32_t materialId)
+        : materialId(materialId) {}
 
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
 
@@ -1,12 +1,14 @@
 #include "geometry/Cylinder.h"
+#include "utils/RenderStats.h"
 
 bool Cylinder::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    RT_STAT_INC(StatCounter::OtherPrimitiveTests);
     float closestT = tMax;
     bool hitAnything = false;
     HitRecord tempRecord;
 
-    const Vec3& origin = ray.origin;
-    const Vec3& direction = ray.direction;
+    const Vec3A& origin = ray.origin;
+    const Vec3A& direction = ray.direction;
 
     float a = direction.x * direction.x + direction.z * direction.z;
 
@@ -35,7 +37,7 @@ bool Cylinder::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) co
                 outwardNormal.Normalize();
 
                 tempRecord.SetFaceNormal(ray, outwardNormal);
-                tempRecord.material = material;
+                tempRecord.materialId = materialId;
 
                 closestT = t;
                 hitAnything = true;
@@ -57,7 +59,7 @@ bool Cylinder::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) co
                 tempRecord.point = hitPoint;
 
                 tempRecord.SetFaceNormal(ray, Vec3(0, 1, 0));
-                tempRecord.material = material;
+                tempRecord.materialId = materialId;
 
                 closestT = t;
                 hitAnything = true;
@@ -75,7 +77,7 @@ bool Cylinder::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) co
                 tempRecord.t = t;
                 tempRecord.point = hitPoint;
                 tempRecord.SetFaceNormal(ray, Vec3(0, -1, 0));
-                tempRecord.material = material;
+                tempRecord.materialId = materialId;
 
                 hitAnything = true;
                 record = tempRecord;
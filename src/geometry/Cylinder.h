@@ -3,12 +3,12 @@
 
 class Cylinder : public Hittable {
 public:
-    std::shared_ptr<Material> material;
+    uint32_t materialId;
 
-    Cylinder() : material(nullptr) {}
+    Cylinder() : materialId(kNoMaterial) {}
 
-    Cylinder(std::shared_ptr<Material> material)
-        : material(material) {}
+    Cylinder(uint32_t materialId)
+        : materialId(materialId) {}
 
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
 
@@ -1,18 +1,22 @@
 #pragma once
 #include "core/Ray.h"
 #include "core/Vec3.h"
+#include "core/Vec3A.h"
 #include "geometry/AABB.h"
 
-class Material; // Forward declaration
+#include <cstdint>
+
+// Material id of surfaces without material; rays ending on them return black
+constexpr uint32_t kNoMaterial = 0xffffffffu;
 
 struct HitRecord {
-    Vec3 point; 
-    Vec3 normal;
-    std::shared_ptr<Material> material;
+    Vec3A point; 
+    Vec3A normal;
+    uint32_t materialId = kNoMaterial; // Index into the scene's MaterialTable
     float t;
     bool frontFace;
 
-    void SetFaceNormal(const Ray& ray, const Vec3& outwardNormal) {
+    void SetFaceNormal(const Ray& ray, const Vec3A& outwardNormal) {
         frontFace = ray.direction.Dot(outwardNormal) < 0;
         normal = frontFace ? outwardNormal : outwardNormal * -1;
     }
@@ -0,0 +1,222 @@
+#include "geometry/LinearBVH.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <memory>
+
+namespace {
+// Below this many primitives the serial build is faster than spinning up workers
+constexpr size_t kParallelBuildThreshold = 64 * 1024;
+}
+
+void LinearBVH::Build(const std::vector<AABB>& primitiveBounds, const BVHBuildOptions& options) {
+    std::vector<BVHPrimitive> prims;
+    prims.reserve(primitiveBounds.size());
+    for (size_t i = 0; i < primitiveBounds.size(); i++) {
+        prims.push_back(BVHPrimitive{ primitiveBounds[i], primitiveBounds[i].Centroid(), static_cast<uint32_t>(i) });
+    }
+    Build(std::move(prims), options);
+}
+
+void LinearBVH::Build(std::vector<BVHPrimitive> prims, const BVHBuildOptions& options) {
+    Clear();
+    if (prims.empty()) return;
+
+    #ifndef __EMSCRIPTEN__
+    if (prims.size() >= kParallelBuildThreshold) {
+        if (options.threadPool) {
+            BuildParallel(prims, options, *options.threadPool);
+        } else {
+            ThreadPool threadPool(std::max(1u, std::thread::hardware_concurrency()));
+            BuildParallel(prims, options, threadPool);
+        }
+        return;
+    }
+    #endif
+
+    nodes.reserve(2 * prims.size());
+    primitiveIndices.reserve(prims.size());
+    BuildRecursive(prims, 0, prims.size(), 0, options);
+    nodes.shrink_to_fit();
+}
+
+void LinearBVH::BuildParallel(std::vector<BVHPrimitive>& prims, const BVHBuildOptions& options, ThreadPool& threadPool) {
+    // Split the top levels until there are several independent subtrees per worker
+    size_t subtreeSize = std::max<size_t>(prims.size() / (8 * std::max(1, threadPool.Size())), 1024);
+
+    std::vector<TopLevelNode> topNodes;
+    std::vector<SubtreeRange> subtreeRanges;
+    SplitTopLevel(prims, options, subtreeSize, threadPool, topNodes, subtreeRanges);
+
+    // The subtree ranges are disjoint, so workers can partition them in place concurrently
+    std::vector<LinearBVH> subtrees(subtreeRanges.size());
+    threadPool.ParallelFor(static_cast<int>(subtreeRanges.size()), [&](int i) {
+        size_t start = subtreeRanges[i].start;
+        size_t end = subtreeRanges[i].end;
+        subtrees[i].nodes.reserve(2 * (end - start));
+        subtrees[i].primitiveIndices.reserve(end - start);
+        subtrees[i].BuildRecursive(prims, start, end, subtreeRanges[i].depth, options);
+    });
+
+    size_t nodeCount = topNodes.size();
+    for (const auto& subtree : subtrees) {
+        nodeCount += subtree.nodes.size();
+    }
+    nodes.reserve(nodeCount);
+    primitiveIndices.reserve(prims.size());
+    EmitTopLevel(topNodes, 0, subtrees);
+}
+
+void LinearBVH::SplitTopLevel(std::vector<BVHPrimitive>& prims, const BVHBuildOptions& options, size_t subtreeSize,
+    ThreadPool& threadPool, std::vector<TopLevelNode>& topNodes, std::vector<SubtreeRange>& subtreeRanges) {
+    struct PendingRange {
+        int topIndex;
+        size_t start;
+        size_t end;
+        size_t mid;
+        int depth;
+    };
+
+    topNodes.emplace_back();
+    std::vector<PendingRange> frontier = { PendingRange{ 0, 0, prims.size(), 0, 0 } };
+
+    // Split one level at a time so every range of a level is partitioned concurrently
+    while (!frontier.empty()) {
+        threadPool.ParallelFor(static_cast<int>(frontier.size()), [&](int i) {
+            PendingRange& range = frontier[i];
+            TopLevelNode& node = topNodes[range.topIndex];
+            if (range.end - range.start <= subtreeSize) {
+                range.mid = range.end;
+                return;
+            }
+
+            node.bounds = AABB::Empty();
+            for (size_t p = range.start; p < range.end; p++) {
+                node.bounds.Expand(prims[p].bounds);
+            }
+            range.mid = SplitPrimitives(prims.data(), range.start, range.end, node.bounds, range.depth, options, &node.axis);
+        });
+
+        std::vector<PendingRange> next;
+        for (const PendingRange& range : frontier) {
+            if (range.mid == range.start || range.mid == range.end) {
+                topNodes[range.topIndex].subtree = static_cast<int>(subtreeRanges.size());
+                subtreeRanges.push_back(SubtreeRange{ range.start, range.end, range.depth });
+                continue;
+            }
+
+            int left = static_cast<int>(topNodes.size());
+            topNodes.emplace_back();
+            topNodes.emplace_back();
+            topNodes[range.topIndex].left = left;
+            topNodes[range.topIndex].right = left + 1;
+            next.push_back(PendingRange{ left, range.start, range.mid, 0, range.depth + 1 });
+            next.push_back(PendingRange{ left + 1, range.mid, range.end, 0, range.depth + 1 });
+        }
+        frontier.swap(next);
+    }
+}
+
+uint32_t LinearBVH::EmitTopLevel(const std::vector<TopLevelNode>& topNodes, int topIndex, const std::vector<LinearBVH>& subtrees) {
+    const TopLevelNode& topNode = topNodes[topIndex];
+
+    if (topNode.subtree >= 0) {
+        // Append the worker's subtree, rebasing its child and primitive offsets
+        const LinearBVH& subtree = subtrees[topNode.subtree];
+        uint32_t nodeBase = static_cast<uint32_t>(nodes.size());
+        uint32_t primitiveBase = static_cast<uint32_t>(primitiveIndices.size());
+
+        for (LinearBVHNode node : subtree.nodes) {
+            node.offset += node.primitiveCount > 0 ? primitiveBase : nodeBase;
+            nodes.push_back(node);
+        }
+        primitiveIndices.insert(primitiveIndices.end(), subtree.primitiveIndices.begin(), subtree.primitiveIndices.end());
+        return nodeBase;
+    }
+
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    LinearBVHNode node = {};
+    node.boundsMin[0] = topNode.bounds.min.x;
+    node.boundsMin[1] = topNode.bounds.min.y;
+    node.boundsMin[2] = topNode.bounds.min.z;
+    node.boundsMax[0] = topNode.bounds.max.x;
+    node.boundsMax[1] = topNode.bounds.max.y;
+    node.boundsMax[2] = topNode.bounds.max.z;
+    node.axis = static_cast<uint8_t>(topNode.axis);
+
+    EmitTopLevel(topNodes, topNode.left, subtrees);
+    node.offset = EmitTopLevel(topNodes, topNode.right, subtrees);
+
+    nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+void LinearBVH::Clear() {
+    nodes.clear();
+    primitiveIndices.clear();
+}
+
+uint32_t LinearBVH::BuildRecursive(std::vector<BVHPrimitive>& prims, size_t start, size_t end, int depth,
+    const BVHBuildOptions& options) {
+    AABB bounds = AABB::Empty();
+    for (size_t i = start; i < end; i++) {
+        bounds.Expand(prims[i].bounds);
+    }
+
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    LinearBVHNode node = {};
+    node.boundsMin[0] = bounds.min.x;
+    node.boundsMin[1] = bounds.min.y;
+    node.boundsMin[2] = bounds.min.z;
+    node.boundsMax[0] = bounds.max.x;
+    node.boundsMax[1] = bounds.max.y;
+    node.boundsMax[2] = bounds.max.z;
+
+    int axis = 0;
+    size_t mid = SplitPrimitives(prims.data(), start, end, bounds, depth, options, &axis);
+
+    if (mid == start || mid == end) {
+        // SplitPrimitives clamps maxLeafSize so every leaf count fits in 16 bits
+        assert(end - start <= std::numeric_limits<uint16_t>::max());
+        node.offset = static_cast<uint32_t>(primitiveIndices.size());
+        node.primitiveCount = static_cast<uint16_t>(end - start);
+        for (size_t i = start; i < end; i++) {
+            primitiveIndices.push_back(prims[i].index);
+        }
+    } else {
+        node.axis = static_cast<uint8_t>(axis);
+        BuildRecursive(prims, start, mid, depth + 1, options);
+        node.offset = BuildRecursive(prims, mid, end, depth + 1, options);
+    }
+
+    nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+bool LinearBVH::BoundingBox(AABB& outputBox) const {
+    if (nodes.empty()) return false;
+    const LinearBVHNode& root = nodes[0];
+    outputBox = AABB(
+        Vec3(root.boundsMin[0], root.boundsMin[1], root.boundsMin[2]),
+        Vec3(root.boundsMax[0], root.boundsMax[1], root.boundsMax[2])
+    );
+    return true;
+}
+
+float LinearBVH::SAHCost() const {
+    if (nodes.empty()) return 0.0f;
+
+    float rootArea = SurfaceArea(nodes[0]);
+    float cost = 0.0f;
+    for (const auto& node : nodes) {
+        float probability = rootArea > 0.0f ? SurfaceArea(node) / rootArea : 1.0f;
+        cost += probability * (node.primitiveCount > 0
+            ? kBVHIntersectionCost * node.primitiveCount
+            : kBVHTraversalCost);
+    }
+    return cost;
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include "geometry/Hittable.h"
+#include "geometry/BVHBuild.h"
+#include "geometry/RayPacket.h"
+#include "utils/RenderStats.h"
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+
+// 32-byte node stored in depth-first order: an interior node's first child
+// directly follows it, so only the second child's index is stored
+struct LinearBVHNode {
+    float boundsMin[3];
+    uint32_t offset;         // Leaf: first entry in primitiveIndices, interior: second child index
+    float boundsMax[3];
+    uint16_t primitiveCount; // 0 for interior nodes
+    uint8_t axis;            // Split axis, used to visit the nearer child first
+    uint8_t pad;
+};
+static_assert(sizeof(LinearBVHNode) == 32, "LinearBVHNode must stay 32 bytes");
+
+inline float SurfaceArea(const LinearBVHNode& node) {
+    float dx = node.boundsMax[0] - node.boundsMin[0];
+    float dy = node.boundsMax[1] - node.boundsMin[1];
+    float dz = node.boundsMax[2] - node.boundsMin[2];
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+class LinearBVH {
+private:
+    std::vector<LinearBVHNode> nodes;
+    std::vector<uint32_t> primitiveIndices;
+
+    // Upper levels of a parallel build, split level by level before the subtrees are handed to workers
+    struct TopLevelNode {
+        AABB bounds;
+        int axis = 0;
+        int left = -1;
+        int right = -1;
+        int subtree = -1;
+    };
+    // Primitive range of a subtree handed to a worker, with the depth its root sits at
+    struct SubtreeRange {
+        size_t start;
+        size_t end;
+        int depth;
+    };
+
+    uint32_t BuildRecursive(std::vector<BVHPrimitive>& prims, size_t start, size_t end, int depth, const BVHBuildOptions& options);
+    void BuildParallel(std::vector<BVHPrimitive>& prims, const BVHBuildOptions& options, ThreadPool& threadPool);
+    void SplitTopLevel(std::vector<BVHPrimitive>& prims, const BVHBuildOptions& options, size_t subtreeSize,
+        ThreadPool& threadPool, std::vector<TopLevelNode>& topNodes, std::vector<SubtreeRange>& subtreeRanges);
+    uint32_t EmitTopLevel(const std::vector<TopLevelNode>& topNodes, int topIndex, const std::vector<LinearBVH>& subtrees);
+
+    static bool NodeHit(const LinearBVHNode& node, const Vec3A& origin, const Vec3A& invDir, float tMin, float tMax) {
+        float t0 = (node.boundsMin[0] - origin.x) * invDir.x;
+        float t1 = (node.boundsMax[0] - origin.x) * invDir.x;
+        if (t0 > t1) std::swap(t0, t1);
+        tMin = t0 > tMin ? t0 : tMin;
+        tMax = t1 < tMax ? t1 : tMax;
+
+        t0 = (node.boundsMin[1] - origin.y) * invDir.y;
+        t1 = (node.boundsMax[1] - origin.y) * invDir.y;
+        if (t0 > t1) std::swap(t0, t1);
+        tMin = t0 > tMin ? t0 : tMin;
+        tMax = t1 < tMax ? t1 : tMax;
+
+        t0 = (node.boundsMin[2] - origin.z) * invDir.z;
+        t1 = (node.boundsMax[2] - origin.z) * invDir.z;
+        if (t0 > t1) std::swap(t0, t1);
+        tMin = t0 > tMin ? t0 : tMin;
+        tMax = t1 < tMax ? t1 : tMax;
+
+        return tMax > tMin;
+    }
+public:
+    void Build(const std::vector<AABB>& primitiveBounds, const BVHBuildOptions& options = BVHBuildOptions());
+    // Builds from prepared primitives, partitioning them in place
+    void Build(std::vector<BVHPrimitive> prims, const BVHBuildOptions& options = BVHBuildOptions());
+    void Clear();
+
+    bool Empty() const { return nodes.empty(); }
+    bool BoundingBox(AABB& outputBox) const;
+    float SAHCost() const;
+    size_t GetMemoryUsage() const {
+        return nodes.capacity() * sizeof(LinearBVHNode) + primitiveIndices.capacity() * sizeof(uint32_t);
+    }
+
+    // Replaces each leaf's primitives with a single cluster id returned by
+    // makeCluster(const uint32_t* primitives, uint32_t count), e.g. the index of a TrianglePack
+    template <typename MakeCluster>
+    void CollapseLeaves(MakeCluster&& makeCluster) {
+        std::vector<uint32_t> clusters;
+        for (LinearBVHNode& node : nodes) {
+            if (node.primitiveCount == 0) continue;
+            uint32_t cluster = makeCluster(&primitiveIndices[node.offset], static_cast<uint32_t>(node.primitiveCount));
+            node.offset = static_cast<uint32_t>(clusters.size());
+            node.primitiveCount = 1;
+            clusters.push_back(cluster);
+        }
+        primitiveIndices = std::move(clusters);
+    }
+
+    const std::vector<LinearBVHNode>& GetNodes() const { return nodes; }
+    const std::vector<uint32_t>& GetPrimitiveIndices() const { return primitiveIndices; }
+    // Adopts a tree built earlier (e.g. read from a scene snapshot); the arrays must come from Build
+    void Assign(std::vector<LinearBVHNode> newNodes, std::vector<uint32_t> newPrimitiveIndices) {
+        nodes = std::move(newNodes);
+        primitiveIndices = std::move(newPrimitiveIndices);
+    }
+
+    // Walks the tree with an explicit stack, calling
+    // hitPrimitive(primitiveIndex, ray, tMin, tMax, record) for each primitive in a visited leaf
+    template <typename HitPrimitive>
+    bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record, HitPrimitive&& hitPrimitive) const {
+        if (nodes.empty()) return false;
+
+        Vec3A invDir = ray.direction.Reciprocal();
+        bool dirIsNeg[3] = { invDir.x < 0.0f, invDir.y < 0.0f, invDir.z < 0.0f };
+
+        // Holds one pending sibling per level; the builders keep trees within kMaxBVHDepth
+        uint32_t stack[kBVHTraversalStackSize];
+        int stackSize = 0;
+        uint32_t current = 0;
+        bool hitAnything = false;
+        LocalStats stats;
+
+        while (true) {
+            const LinearBVHNode& node = nodes[current];
+            stats.Add(StatCounter::NodeVisits);
+            stats.Add(StatCounter::AABBTests);
+            if (NodeHit(node, ray.origin, invDir, tMin, tMax)) {
+                if (node.primitiveCount > 0) {
+                    for (uint32_t i = 0; i < node.primitiveCount; i++) {
+                        if (hitPrimitive(primitiveIndices[node.offset + i], ray, tMin, tMax, record)) {
+                            hitAnything = true;
+                            tMax = record.t;
+                        }
+                    }
+                    if (stackSize == 0) break;
+                    current = stack[--stackSize];
+                } else if (dirIsNeg[node.axis]) {
+                    assert(stackSize < kBVHTraversalStackSize);
+                    stack[stackSize++] = current + 1;
+                    current = node.offset;
+                } else {
+                    assert(stackSize < kBVHTraversalStackSize);
+                    stack[stackSize++] = node.offset;
+                    current = current + 1;
+                }
+            } else {
+                if (stackSize == 0) break;
+                current = stack[--stackSize];
+            }
+        }
+
+        return hitAnything;
+    }
+
+    // Traverses the tree with a whole packet. Coherent packets first cull each node with the
+    // interval test, then skip to the first ray that actually hits it; visitLeaf(primitiveIndex, firstRay)
+    // intersects rays [firstRay, packet.size) with the primitive and lowers their tMax on hits.
+    template <typename VisitLeaf>
+    void HitPacket(RayPacket& packet, int firstRay, float tMin, VisitLeaf&& visitLeaf) const {
+        if (nodes.empty() || firstRay >= packet.size) return;
+
+        struct StackEntry {
+            uint32_t node;
+            int firstRay;
+        };
+        // Both children are pushed, so an interior node at depth d leaves at most d + 2 entries (64 at kMaxBVHDepth - 1)
+        StackEntry stack[kBVHTraversalStackSize];
+        int stackSize = 0;
+        stack[stackSize++] = StackEntry{ 0, firstRay };
+        LocalStats stats;
+
+        while (stackSize > 0) {
+            StackEntry entry = stack[--stackSize];
+            const LinearBVHNode& node = nodes[entry.node];
+            stats.Add(StatCounter::NodeVisits);
+            if (packet.coherent) {
+                stats.Add(StatCounter::AABBTests);
+                if (!packet.IntervalHit(node.boundsMin, node.boundsMax, tMin)) continue;
+            }
+
+            int first = entry.firstRay;
+            while (first < packet.size && !NodeHit(node, packet.rays[first].origin, packet.invDir[first], tMin, packet.tMax[first])) {
+                first++;
+            }
+            stats.Add(StatCounter::AABBTests, std::min(first + 1, packet.size) - entry.firstRay);
+            if (first == packet.size) continue;
+
+            if (node.primitiveCount > 0) {
+                for (uint32_t i = 0; i < node.primitiveCount; i++) {
+                    visitLeaf(primitiveIndices[node.offset + i], first);
+                }
+                packet.UpdateMaxT();
+                continue;
+            }
+
+            // Coherent rays share direction signs, so the first active ray orders the children for all of them
+            uint32_t nearChild = entry.node + 1;
+            uint32_t farChild = node.offset;
+            if (packet.invDir[first][node.axis] < 0.0f) std::swap(nearChild, farChild);
+            assert(stackSize < kBVHTraversalStackSize);
+            stack[stackSize++] = StackEntry{ farChild, first };
+            assert(stackSize < kBVHTraversalStackSize);
+            stack[stackSize++] = StackEntry{ nearChild, first };
+        }
+    }
+};
@@ -1,42 +1,109 @@
 #include "geometry/Mesh.h"
-#include <fstream>
-#include <sstream>
+#include "geometry/MeshFile.h"
+#include "geometry/ObjParser.h"
 #include <iostream>
 #include <filesystem>
+#include <chrono>
+#include <algorithm>
+#include "utils/MemoryStats.h"
+#include "utils/RenderStats.h"
 
-bool Mesh::LoadFromOBJ(const std::string& filename) {
+bool Mesh::LoadFromOBJ(const std::string& filename, bool useCache, ThreadPool* threadPool) {
     std::cout << "Current directory: " << std::filesystem::current_path() << std::endl;
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open OBJ file: " << filename << std::endl;
+    auto loadStart = std::chrono::steady_clock::now();
+    std::vector<Vec3> objVertices;
+    std::vector<uint32_t> objIndices;
+
+    FileStamp stamp;
+    std::string cachePath = filename + kMeshCacheExtension;
+    bool cached = useCache && GetFileStamp(filename, stamp) && LoadMeshFile(cachePath, objVertices, objIndices, &stamp);
+    if (!cached) {
+        if (!ParseOBJFile(filename, objVertices, objIndices, threadPool)) return false;
+        if (useCache && !SaveMeshFile(cachePath, objVertices, objIndices, stamp)) {
+            std::cerr << "Warning: Could not write mesh cache " << cachePath << std::endl;
+        }
+    }
+
+    // OBJ indices address the file's vertices, which start after any existing geometry
+    AddTriangles(objVertices, objIndices);
+    vertices.shrink_to_fit();
+    indices.shrink_to_fit();
+
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "Loaded mesh with " << GetTriangleCount() << " triangles" << (cached ? " from " + cachePath : "")
+              << " in " << loadMs << " ms." << std::endl;
+
+    return true;
+}
+
+bool Mesh::LoadFromBinary(const std::string& filename) {
+    std::vector<Vec3> fileVertices;
+    std::vector<uint32_t> fileIndices;
+    if (!LoadMeshFile(filename, fileVertices, fileIndices)) {
+        std::cerr << "Error: Could not load mesh file: " << filename << std::endl;
         return false;
     }
-    std::vector<Vec3> vertices;
-    std::string line;
-
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string type;
-        iss >> type;
-
-        if (type == "v") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            vertices.push_back(Vec3(x, y, z));
-        }
-        else if (type == "f") {
-            std::string v1, v2, v3;
-            iss >> v1 >> v2 >> v3;
+    AddTriangles(fileVertices, fileIndices);
+    return true;
+}
+
+bool Mesh::SaveBinary(const std::string& filename) const {
+    return SaveMeshFile(filename, vertices, indices);
+}
+
+bool Mesh::HitTriangle(uint32_t triangle, const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    RT_STAT_INC(StatCounter::TriangleTests);
+    Vec3A v0 = vertices[indices[3 * triangle]];
+    Vec3A e1 = Vec3A(vertices[indices[3 * triangle + 1]]) - v0;
+    Vec3A e2 = Vec3A(vertices[indices[3 * triangle + 2]]) - v0;
+
+    float t;
+    if (!Triangle::Intersect(v0, e1, e2, ray, tMin, tMax, t))
+        return false;
 
-            int idx1 = std::stoi(v1.substr(0, v1.find('/'))) - 1;
-            int idx2 = std::stoi(v2.substr(0, v2.find('/'))) - 1;
-            int idx3 = std::stoi(v3.substr(0, v3.find('/'))) - 1;
+    record.t = t;
+    record.point = ray.At(t);
+    record.normal = e1.Cross(e2).Normalize();
+    record.materialId = materialId;
 
-            AddTriangle(Triangle(vertices[idx1], vertices[idx2], vertices[idx3], material));
+    return true;
+}
+
+template <int Width>
+uint32_t Mesh::AddPack(std::vector<TrianglePack<Width>>& packs, const uint32_t* triangles, uint32_t count) const {
+    TrianglePack<Width> pack = {};
+    pack.count = count;
+    for (uint32_t lane = 0; lane < count; lane++) {
+        uint32_t triangle = triangles[lane];
+        const Vec3& v0 = vertices[indices[3 * triangle]];
+        Vec3 e1 = vertices[indices[3 * triangle + 1]] - v0;
+        Vec3 e2 = vertices[indices[3 * triangle + 2]] - v0;
+        for (int a = 0; a < 3; a++) {
+            pack.v0[a][lane] = v0[a];
+            pack.e1[a][lane] = e1[a];
+            pack.e2[a][lane] = e2[a];
         }
+        pack.triangle[lane] = triangle;
     }
+    packs.push_back(pack);
+    return static_cast<uint32_t>(packs.size() - 1);
+}
 
-    std::cout << "Loaded mesh with " << triangles.size() << " triangles." << std::endl;
+template <int Width>
+bool Mesh::HitPack(const TrianglePack<Width>& pack, const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    RT_STAT_ADD(StatCounter::TriangleTests, pack.count);
+    float t;
+    int lane = IntersectTrianglePack(pack, ray, tMin, tMax, t);
+    if (lane < 0)
+        return false;
+
+    Vec3A e1(pack.e1[0][lane], pack.e1[1][lane], pack.e1[2][lane]);
+    Vec3A e2(pack.e2[0][lane], pack.e2[1][lane], pack.e2[2][lane]);
+
+    record.t = t;
+    record.point = ray.At(t);
+    record.normal = e1.Cross(e2).Normalize();
+    record.materialId = materialId;
 
     return true;
 }
@@ -46,25 +113,60 @@ bool Mesh::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const
         BuildBVH();
     }
 
-    if (meshBVH) {
-        return meshBVH->Hit(ray, tMin, tMax, record);
+    if (!meshBVH.Empty()) {
+        if (packWidth == 8) {
+            return meshBVH.Hit(ray, tMin, tMax, record,
+                [this](uint32_t pack, const Ray& r, float t0, float t1, HitRecord& rec) {
+                    return HitPack(packs8[pack], r, t0, t1, rec);
+                });
+        }
+        if (packWidth == 4) {
+            return meshBVH.Hit(ray, tMin, tMax, record,
+                [this](uint32_t pack, const Ray& r, float t0, float t1, HitRecord& rec) {
+                    return HitPack(packs4[pack], r, t0, t1, rec);
+                });
+        }
+        return meshBVH.Hit(ray, tMin, tMax, record,
+            [this](uint32_t index, const Ray& r, float t0, float t1, HitRecord& rec) {
+                return HitTriangle(index, r, t0, t1, rec);
+            });
     }
 
     std::cout << "No BVH found, checking triangles individually." << std::endl;
     bool hitAnything = false;
     float closestSoFar = tMax;
 
-    for (const auto& triangle : triangles) {
-        HitRecord tempRecord;
-        if (triangle.Hit(ray, tMin, closestSoFar, tempRecord)) {
+    for (uint32_t i = 0; i < GetTriangleCount(); i++) {
+        if (HitTriangle(i, ray, tMin, closestSoFar, record)) {
             hitAnything = true;
-            closestSoFar = tempRecord.t;
-            record = tempRecord;
+            closestSoFar = record.t;
         }
     }
 
     return hitAnything;
 }
+void Mesh::HitPacket(RayPacket& packet, int firstRay, float tMin) const {
+    if (!bvhBuilt) {
+        BuildBVH();
+    }
+
+    meshBVH.HitPacket(packet, firstRay, tMin, [&](uint32_t index, int first) {
+        for (int i = first; i < packet.size; i++) {
+            bool hit;
+            if (packWidth == 8) {
+                hit = HitPack(packs8[index], packet.rays[i], tMin, packet.tMax[i], packet.records[i]);
+            } else if (packWidth == 4) {
+                hit = HitPack(packs4[index], packet.rays[i], tMin, packet.tMax[i], packet.records[i]);
+            } else {
+                hit = HitTriangle(index, packet.rays[i], tMin, packet.tMax[i], packet.records[i]);
+            }
+            if (hit) {
+                packet.hit[i] = true;
+                packet.tMax[i] = packet.records[i].t;
+            }
+        }
+    });
+}
 
 bool Mesh::BoundingBox(AABB& outputBox) const {
     if (boundingBoxCached) {
@@ -76,7 +178,7 @@ bool Mesh::BoundingBox(AABB& outputBox) const {
         BuildBVH();
     }
 
-    bool result = meshBVH->BoundingBox(outputBox);
+    bool result = meshBVH.BoundingBox(outputBox);
     if (result) {
         boundingBox = outputBox;
         boundingBoxCached = true;
@@ -84,16 +186,57 @@ bool Mesh::BoundingBox(AABB& outputBox) const {
     return result;
 }
 
-void Mesh::BuildBVH() const {
-    if (bvhBuilt || triangles.empty()) return;
+void Mesh::BuildBVH(const BVHBuildOptions& options) const {
+    if (indices.empty()) return;
 
-    std::vector<std::shared_ptr<Hittable>> trianglePtrs;
-    trianglePtrs.reserve(triangles.size());
+    auto buildStart = std::chrono::steady_clock::now();
 
-    for (const auto& triangle : triangles) {
-        trianglePtrs.push_back(std::make_shared<Triangle>(triangle));
+    std::vector<BVHPrimitive> prims(GetTriangleCount());
+    for (size_t i = 0; i < prims.size(); i++) {
+        prims[i].bounds = Triangle::Bounds(vertices[indices[3 * i]], vertices[indices[3 * i + 1]], vertices[indices[3 * i + 2]]);
+        prims[i].centroid = prims[i].bounds.Centroid();
+        prims[i].index = static_cast<uint32_t>(i);
     }
 
-    meshBVH = std::make_shared<BVHNode>(trianglePtrs, 0, trianglePtrs.size());
+    packs4.clear();
+    packs8.clear();
+    packWidth = options.leafPackWidth >= 8 ? 8 : (options.leafPackWidth >= 4 ? 4 : 1);
+    if (packWidth == 1) {
+        meshBVH.Build(std::move(prims), options);
+    } else {
+        // A leaf must fit in a single pack
+        BVHBuildOptions packedOptions = options;
+        packedOptions.leafPackWidth = packWidth;
+        packedOptions.maxLeafSize = std::min(std::max(options.maxLeafSize, 1), packWidth);
+        if (packWidth == 8) {
+            meshBVH.BuildClustered(std::move(prims), packedOptions,
+                [this](const uint32_t* triangles, uint32_t count) { return AddPack(packs8, triangles, count); });
+            packs8.shrink_to_fit();
+        } else {
+            meshBVH.BuildClustered(std::move(prims), packedOptions,
+                [this](const uint32_t* triangles, uint32_t count) { return AddPack(packs4, triangles, count); });
+            packs4.shrink_to_fit();
+        }
+    }
     bvhBuilt = true;
+
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    std::cout << "Built mesh BVH over " << GetTriangleCount() << " triangles in " << buildMs << " ms, SAH cost "
+              << meshBVH.SAHCost() << ", " << GetMemoryUsage() / GetTriangleCount() << " bytes/triangle, peak memory "
+              << GetPeakResidentBytes() / (1024 * 1024) << " MB" << std::endl;
+}
+
+void Mesh::AssignBVH(LinearBVH binary, BVHLayout layout, int leafPackWidth,
+    std::vector<TrianglePack<4>> leafPacks4, std::vector<TrianglePack<8>> leafPacks8) {
+    meshBVH.Assign(std::move(binary), layout);
+    packWidth = leafPackWidth;
+    packs4 = std::move(leafPacks4);
+    packs8 = std::move(leafPacks8);
+    bvhBuilt = true;
+    boundingBoxCached = false;
+}
+
+size_t Mesh::GetMemoryUsage() const {
+    return vertices.capacity() * sizeof(Vec3) + indices.capacity() * sizeof(uint32_t) + meshBVH.GetMemoryUsage()
+        + packs4.capacity() * sizeof(TrianglePack<4>) + packs8.capacity() * sizeof(TrianglePack<8>);
 }
\ No newline at end of file
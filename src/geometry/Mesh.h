@@ -1,46 +1,114 @@
+#pragma once
 #include "geometry/Hittable.h"
 #include "geometry/Triangle.h"
-#include "geometry/BVHNode.h"
+#include "geometry/BVH.h"
+#include "geometry/TrianglePack.h"
 #include <vector>
 #include <string>
+#include <cstdint>
 
+// Triangle mesh stored as a shared vertex buffer plus a 32-bit index buffer
+// (three indices per triangle). Edges and normals are derived on the fly,
+// and the BVH references triangles by index.
 class Mesh : public Hittable {
 private:
-    std::vector<Triangle> triangles;
-    mutable std::shared_ptr<BVHNode> meshBVH;
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    mutable BVH meshBVH;
     mutable bool bvhBuilt = false;
+    // Leaf triangles copied into SIMD packs; the BVH leaves then hold pack indices
+    mutable std::vector<TrianglePack<4>> packs4;
+    mutable std::vector<TrianglePack<8>> packs8;
+    mutable int packWidth = 1;
 
-    void BuildBVH() const;
+    bool HitTriangle(uint32_t triangle, const Ray& ray, float tMin, float tMax, HitRecord& record) const;
+    template <int Width>
+    uint32_t AddPack(std::vector<TrianglePack<Width>>& packs, const uint32_t* triangles, uint32_t count) const;
+    template <int Width>
+    bool HitPack(const TrianglePack<Width>& pack, const Ray& ray, float tMin, float tMax, HitRecord& record) const;
 public:
-    std::shared_ptr<Material> material;
+    uint32_t materialId;
 
-    Mesh() : material(nullptr) {}
-    Mesh(std::shared_ptr<Material> material) 
-        : material(material) {}
+    Mesh() : materialId(kNoMaterial) {}
+    Mesh(uint32_t materialId)
+        : materialId(materialId) {}
 
     void AddTriangle(const Triangle& triangle) {
-        triangles.push_back(triangle);
+        uint32_t base = static_cast<uint32_t>(vertices.size());
+        vertices.push_back(triangle.v0);
+        vertices.push_back(triangle.v1);
+        vertices.push_back(triangle.v2);
+        indices.push_back(base);
+        indices.push_back(base + 1);
+        indices.push_back(base + 2);
         bvhBuilt = false;
         boundingBoxCached = false;
     }
 
-    void AddTriangles(const std::vector<Triangle>& vertices, const std::vector<int>& indices) {
-        for (size_t i = 0; i < indices.size(); i += 3) {
-            if (i + 2 >= indices.size()) break;
-            const Vec3& v0 = vertices[indices[i]].v0;
-            const Vec3& v1 = vertices[indices[i + 1]].v0;
-            const Vec3& v2 = vertices[indices[i + 2]].v0;
-            triangles.emplace_back(v0, v1, v2, material);
+    // Appends indexed geometry; indices are relative to the given vertex array
+    void AddTriangles(const std::vector<Vec3>& newVertices, const std::vector<uint32_t>& newIndices) {
+        uint32_t base = static_cast<uint32_t>(vertices.size());
+        vertices.insert(vertices.end(), newVertices.begin(), newVertices.end());
+        for (size_t i = 0; i + 2 < newIndices.size(); i += 3) {
+            indices.push_back(base + newIndices[i]);
+            indices.push_back(base + newIndices[i + 1]);
+            indices.push_back(base + newIndices[i + 2]);
         }
         bvhBuilt = false;
         boundingBoxCached = false;
     }
 
-    bool LoadFromOBJ(const std::string& filename);
+    // Appends the triangles of an OBJ file (see ParseOBJ; large files are parsed in parallel on threadPool).
+    // With useCache, a binary copy is kept next to it (filename + ".rtmesh") and loaded instead of parsing
+    // for as long as the OBJ's size and modification time are unchanged.
+    bool LoadFromOBJ(const std::string& filename, bool useCache = true, ThreadPool* threadPool = nullptr);
+
+    // Appends the triangles of a binary mesh file (see MeshFile.h)
+    bool LoadFromBinary(const std::string& filename);
+    bool SaveBinary(const std::string& filename) const;
+
+    // Default mesh options: leaves of up to one pack of triangles, sized for the active SIMD level
+    static BVHBuildOptions DefaultBuildOptions() {
+        BVHBuildOptions options;
+        options.leafPackWidth = PreferredTrianglePackWidth();
+        options.maxLeafSize = options.leafPackWidth;
+        return options;
+    }
+
+    // Builds (or rebuilds) the triangle BVH; Hit builds one with default options if needed.
+    // A leafPackWidth of 4 or 8 stores leaves as TrianglePacks, 1 keeps per-triangle leaves.
+    void BuildBVH(const BVHBuildOptions& options = DefaultBuildOptions()) const;
+
+    void SetBVHLayout(BVHLayout layout) { meshBVH.SetLayout(layout); }
+
+    // Built BVH and leaf packs, for saving; GetPackWidth is 1 when leaves hold triangle indices
+    bool IsBVHBuilt() const { return bvhBuilt; }
+    const BVH& GetBVH() const { return meshBVH; }
+    int GetPackWidth() const { return packWidth; }
+    const std::vector<TrianglePack<4>>& GetPacks4() const { return packs4; }
+    const std::vector<TrianglePack<8>>& GetPacks8() const { return packs8; }
+    // Adopts a BVH saved from a mesh with the same vertices and indices instead of building one
+    void AssignBVH(LinearBVH binary, BVHLayout layout, int leafPackWidth,
+        std::vector<TrianglePack<4>> leafPacks4, std::vector<TrianglePack<8>> leafPacks8);
+
+    // SAH cost of the triangle BVH, or 0 if it has not been built
+    float GetBVHCost() const { return meshBVH.SAHCost(); }
 
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
 
+    // Intersects rays [firstRay, packet.size) with the mesh, filling records and lowering tMax on hits
+    void HitPacket(RayPacket& packet, int firstRay, float tMin) const;
+
     virtual bool BoundingBox(AABB& outputBox) const override;
 
-    const std::vector<Triangle>& GetTriangles() const {return triangles;}
-};
\ No newline at end of file
+    size_t GetTriangleCount() const { return indices.size() / 3; }
+    const std::vector<Vec3>& GetVertices() const { return vertices; }
+    const std::vector<uint32_t>& GetIndices() const { return indices; }
+    Triangle GetTriangle(size_t triangle) const {
+        return Triangle(vertices[indices[3 * triangle]], vertices[indices[3 * triangle + 1]],
+            vertices[indices[3 * triangle + 2]], materialId);
+    }
+
+    // Resident bytes of the geometry and BVH
+    size_t GetMemoryUsage() const;
+};
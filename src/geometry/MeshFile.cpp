@@ -0,0 +1,162 @@
+#include "geometry/MeshFile.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RT_HAVE_MMAP 1
+#endif
+
+static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 arrays are stored as raw floats");
+
+namespace {
+const char kMeshFileMagic[8] = { 'R', 'T', 'M', 'E', 'S', 'H', 0, 0 };
+}
+
+bool GetFileStamp(const std::string& path, FileStamp& stamp) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    if (error) return false;
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error) return false;
+    stamp.size = static_cast<uint64_t>(size);
+    stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+bool SaveMeshFile(const std::string& path, const std::vector<Vec3>& vertices, const std::vector<uint32_t>& indices,
+    const FileStamp& source) {
+    MeshFileHeader header = {};
+    std::memcpy(header.magic, kMeshFileMagic, sizeof(header.magic));
+    header.version = kMeshFileVersion;
+    header.headerSize = sizeof(MeshFileHeader);
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(vertices.data()), std::streamsize(vertices.size() * sizeof(Vec3)));
+        file.write(reinterpret_cast<const char*>(indices.data()), std::streamsize(indices.size() * sizeof(uint32_t)));
+        if (!file) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool LoadMeshFile(const std::string& path, std::vector<Vec3>& vertices, std::vector<uint32_t>& indices,
+    const FileStamp* source) {
+    MappedFile file;
+    if (!file.Open(path)) return false;
+    if (file.Size() < sizeof(MeshFileHeader)) return false;
+
+    MeshFileHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kMeshFileMagic, sizeof(header.magic)) != 0 ||
+        header.version != kMeshFileVersion || header.headerSize != sizeof(MeshFileHeader)) {
+        return false;
+    }
+    if (source && (header.sourceSize != source->size || header.sourceTime != source->time)) return false;
+    if (header.indexCount % 3 != 0) return false;
+
+    uint64_t vertexBytes = header.vertexCount * sizeof(Vec3);
+    uint64_t indexBytes = header.indexCount * sizeof(uint32_t);
+    if (header.vertexCount > file.Size() || header.indexCount > file.Size() ||
+        sizeof(MeshFileHeader) + vertexBytes + indexBytes != file.Size()) {
+        return false;
+    }
+
+    const unsigned char* vertexData = file.Data() + sizeof(MeshFileHeader);
+    const unsigned char* indexData = vertexData + vertexBytes;
+    size_t firstVertex = vertices.size();
+    size_t firstIndex = indices.size();
+    vertices.resize(firstVertex + header.vertexCount);
+    indices.resize(firstIndex + header.indexCount);
+    std::memcpy(vertices.data() + firstVertex, vertexData, size_t(vertexBytes));
+    std::memcpy(indices.data() + firstIndex, indexData, size_t(indexBytes));
+
+    // A damaged file must not leave indices pointing outside the vertex array
+    for (size_t i = firstIndex; i < indices.size(); i++) {
+        if (indices[i] >= header.vertexCount) {
+            vertices.resize(firstVertex);
+            indices.resize(firstIndex);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+#if defined(RT_HAVE_MMAP)
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) return false;
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        close(descriptor);
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        close(descriptor);
+        data = buffer.data();
+        return true;
+    }
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (address == MAP_FAILED) {
+        size = 0;
+        return false;
+    }
+    // The contents are copied out front to back
+    madvise(address, size, MADV_SEQUENTIAL);
+    data = static_cast<const unsigned char*>(address);
+    mapped = true;
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamsize length = file.tellg();
+    if (length < 0) return false;
+    buffer.resize(static_cast<size_t>(length));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), length)) {
+        buffer.clear();
+        return false;
+    }
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+#endif
+}
+
+void MappedFile::Close() {
+#if defined(RT_HAVE_MMAP)
+    if (mapped) munmap(const_cast<unsigned char*>(data), size);
+#endif
+    mapped = false;
+    data = nullptr;
+    size = 0;
+    buffer.clear();
+    buffer.shrink_to_fit();
+}
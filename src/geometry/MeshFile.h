@@ -0,0 +1,64 @@
+#pragma once
+#include "core/Vec3.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary mesh file: a fixed header followed by the raw vertex array (three floats per vertex) and the
+// index array (three uint32 per triangle), both in native little-endian layout, so loading is two copies
+// out of a mapped file. The header records the size and modification time of the file it was converted
+// from, which lets it serve as a cache that goes stale when the source changes.
+struct MeshFileHeader {
+    char magic[8];          // "RTMESH\0\0"
+    uint32_t version;
+    uint32_t headerSize;    // sizeof(MeshFileHeader), guards against layout changes
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t sourceSize;    // 0 when not converted from another file
+    int64_t sourceTime;
+};
+
+// Bumped whenever the OBJ conversion changes, so caches written by an older parser are regenerated
+constexpr uint32_t kMeshFileVersion = 2;
+
+// Extension appended to a source path to name its conversion cache, e.g. monkey.obj.rtmesh
+constexpr const char* kMeshCacheExtension = ".rtmesh";
+
+// Size and modification time identifying one version of a file on disk
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t time = 0;
+};
+
+// Stamp of path; false if the file does not exist
+bool GetFileStamp(const std::string& path, FileStamp& stamp);
+
+// Writes the geometry through a temporary file renamed into place, so readers never see a partial file
+bool SaveMeshFile(const std::string& path, const std::vector<Vec3>& vertices, const std::vector<uint32_t>& indices,
+    const FileStamp& source = FileStamp());
+
+// Reads a mesh file, appending to vertices and indices as stored (indices are not rebased). Fails without
+// touching the arrays if the file is missing, malformed, or, when source is given, stamped differently.
+bool LoadMeshFile(const std::string& path, std::vector<Vec3>& vertices, std::vector<uint32_t>& indices,
+    const FileStamp* source = nullptr);
+
+// Read-only view of a whole file, memory-mapped where the platform allows and read into memory elsewhere
+class MappedFile {
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::vector<unsigned char> buffer;
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+};
@@ -0,0 +1,54 @@
+#include "geometry/MeshInstance.h"
+#include "geometry/Mesh.h"
+
+MeshInstance::MeshInstance(uint32_t meshIndex, const Vec3& position, const Vec3& rotation, const Vec3& scale)
+    : transform(AffineTransform::Compose(position, rotation, scale)), meshIndex(meshIndex) {}
+
+MeshInstance::MeshInstance(uint32_t meshIndex, const AffineTransform& objectToWorld)
+    : transform(objectToWorld), meshIndex(meshIndex) {}
+
+AABB MeshInstance::WorldBounds(const AABB& localBounds) const {
+    AABB worldBounds = AABB::Empty();
+    for (int i = 0; i < 8; i++) {
+        Vec3 corner(
+            (i & 1) ? localBounds.max.x : localBounds.min.x,
+            (i & 2) ? localBounds.max.y : localBounds.min.y,
+            (i & 4) ? localBounds.max.z : localBounds.min.z
+        );
+        worldBounds.Expand(transform.objectToWorld.TransformPoint(corner));
+    }
+    return worldBounds;
+}
+
+bool MeshInstance::Hit(const Hittable& mesh, const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    // The local direction keeps its length, so t is the same parameter in both spaces
+    if (!mesh.Hit(transform.ToObject(ray), tMin, tMax, record)) {
+        return false;
+    }
+
+    record.point = transform.PointToWorld(record.point);
+    record.normal = transform.NormalToWorld(record.normal);
+    return true;
+}
+
+void MeshInstance::HitPacket(const Mesh& mesh, RayPacket& packet, int firstRay, float tMin) const {
+    // Local directions are left unnormalized, so hit distances need no rescaling
+    RayPacket localPacket;
+    for (int i = firstRay; i < packet.size; i++) {
+        localPacket.Add(transform.ToObject(packet.rays[i]), packet.tMax[i]);
+    }
+    localPacket.Finalize();
+
+    mesh.HitPacket(localPacket, 0, tMin);
+
+    for (int j = 0; j < localPacket.size; j++) {
+        if (!localPacket.hit[j]) continue;
+        int i = firstRay + j;
+        HitRecord& record = packet.records[i];
+        record = localPacket.records[j];
+        record.point = transform.PointToWorld(record.point);
+        record.normal = transform.NormalToWorld(record.normal);
+        packet.tMax[i] = record.t;
+        packet.hit[i] = true;
+    }
+}
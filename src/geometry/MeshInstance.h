@@ -0,0 +1,26 @@
+#pragma once
+#include "geometry/Hittable.h"
+#include "geometry/RayPacket.h"
+#include "core/AffineTransform.h"
+#include <cstdint>
+
+class Mesh;
+
+// Placement of a shared mesh in the scene's top-level BVH. Only the
+// transform is stored per instance; the geometry and its bottom-level
+// BVH live once in the mesh referenced by meshIndex.
+class MeshInstance {
+public:
+    ObjectTransform transform;
+    uint32_t meshIndex;
+
+    MeshInstance(uint32_t meshIndex, const Vec3& position, const Vec3& rotation, const Vec3& scale);
+    MeshInstance(uint32_t meshIndex, const AffineTransform& objectToWorld);
+
+    AABB WorldBounds(const AABB& localBounds) const;
+
+    bool Hit(const Hittable& mesh, const Ray& ray, float tMin, float tMax, HitRecord& record) const;
+
+    // Moves rays [firstRay, packet.size) into object space as one packet and traces them through the mesh
+    void HitPacket(const Mesh& mesh, RayPacket& packet, int firstRay, float tMin) const;
+};
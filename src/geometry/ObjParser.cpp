@@ -0,0 +1,247 @@
+#include "geometry/ObjParser.h"
+#include "geometry/MeshFile.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+namespace {
+// Below this many bytes a single thread parses the whole file
+constexpr size_t kParallelParseThreshold = 4 * 1024 * 1024;
+constexpr size_t kMinChunkSize = 1024 * 1024;
+
+// Geometry of a range of whole lines. Negative OBJ indices refer back from the current vertex count,
+// which is only known once the chunks before are parsed, so they are stored as int32 offsets from the
+// chunk's first vertex and listed in relative until the merge.
+struct ObjChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<size_t> relative;
+    const char* errorLine = nullptr; // Start of the first malformed line
+    const char* errorMessage = nullptr;
+};
+
+struct ObjCorner {
+    int64_t index;
+    bool relative;
+};
+
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* SkipSpaces(const char* p, const char* end) {
+    while (p < end && IsSpace(*p)) p++;
+    return p;
+}
+
+bool ParseFloat(const char*& p, const char* end, float& value) {
+    if (p < end && *p == '+') p++;
+#if defined(__cpp_lib_to_chars)
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+#else
+    // Standard libraries without floating-point from_chars: strtof on a terminated copy of the token
+    char buffer[64];
+    size_t length = std::min<size_t>(size_t(end - p), sizeof(buffer) - 1);
+    std::memcpy(buffer, p, length);
+    buffer[length] = '\0';
+    char* stop = nullptr;
+    value = std::strtof(buffer, &stop);
+    if (stop == buffer) return false;
+    p += stop - buffer;
+    return true;
+#endif
+}
+
+bool ParseInt(const char*& p, const char* end, int64_t& value) {
+    if (p < end && *p == '+') p++;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+void ParseChunk(ObjChunk& chunk) {
+    std::vector<ObjCorner> corners;
+    auto fail = [&](const char* line, const char* message) {
+        chunk.errorLine = line;
+        chunk.errorMessage = message;
+    };
+
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', size_t(chunk.end - p)));
+        if (!lineEnd) lineEnd = chunk.end;
+        const char* line = p;
+        const char* q = SkipSpaces(p, lineEnd);
+        p = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+        if (lineEnd - q < 2 || !IsSpace(q[1])) continue;
+
+        if (q[0] == 'v') {
+            float xyz[3];
+            q++;
+            for (float& coordinate : xyz) {
+                q = SkipSpaces(q, lineEnd);
+                if (!ParseFloat(q, lineEnd, coordinate)) return fail(line, "vertex needs three coordinates");
+            }
+            chunk.vertices.push_back(Vec3(xyz[0], xyz[1], xyz[2]));
+        } else if (q[0] == 'f') {
+            corners.clear();
+            q++;
+            while (true) {
+                q = SkipSpaces(q, lineEnd);
+                if (q == lineEnd || *q == '#') break;
+                int64_t index;
+                if (!ParseInt(q, lineEnd, index) || index == 0) return fail(line, "invalid face index");
+                if (index > 0) {
+                    if (index > int64_t(std::numeric_limits<uint32_t>::max())) return fail(line, "face index out of range");
+                    corners.push_back(ObjCorner{ index - 1, false });
+                } else {
+                    int64_t offset = int64_t(chunk.vertices.size()) + index;
+                    if (offset < std::numeric_limits<int32_t>::min()) return fail(line, "face index out of range");
+                    corners.push_back(ObjCorner{ offset, true });
+                }
+                // Texture and normal references (/vt, //vn, /vt/vn) are not used
+                while (q < lineEnd && !IsSpace(*q)) q++;
+            }
+            if (corners.size() < 3) return fail(line, "face needs at least three vertices");
+
+            // Fan triangulation around the first corner
+            for (size_t i = 1; i + 1 < corners.size(); i++) {
+                for (const ObjCorner& corner : { corners[0], corners[i], corners[i + 1] }) {
+                    if (corner.relative) {
+                        chunk.relative.push_back(chunk.indices.size());
+                        chunk.indices.push_back(static_cast<uint32_t>(static_cast<int32_t>(corner.index)));
+                    } else {
+                        chunk.indices.push_back(static_cast<uint32_t>(corner.index));
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Splits data into about count ranges of whole lines
+std::vector<ObjChunk> SplitChunks(const char* data, size_t size, size_t count) {
+    std::vector<ObjChunk> chunks;
+    const char* begin = data;
+    const char* end = data + size;
+    for (size_t i = 1; i <= count && begin < end; i++) {
+        const char* chunkEnd = i == count ? end : std::max(begin, data + size * i / count);
+        if (chunkEnd < end) {
+            const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', size_t(end - chunkEnd)));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        ObjChunk chunk;
+        chunk.begin = begin;
+        chunk.end = chunkEnd;
+        chunks.push_back(std::move(chunk));
+        begin = chunkEnd;
+    }
+    return chunks;
+}
+
+bool ParseChunks(const char* data, std::vector<ObjChunk>& chunks, std::vector<Vec3>& vertices,
+    std::vector<uint32_t>& indices, ThreadPool* threadPool) {
+    auto forEachChunk = [&](const std::function<void(int)>& function) {
+        if (threadPool && chunks.size() > 1) {
+            threadPool->ParallelFor(static_cast<int>(chunks.size()), function);
+        } else {
+            for (int i = 0; i < static_cast<int>(chunks.size()); i++) function(i);
+        }
+    };
+    forEachChunk([&](int i) { ParseChunk(chunks[i]); });
+
+    for (const ObjChunk& chunk : chunks) {
+        if (chunk.errorLine) {
+            size_t line = 1 + size_t(std::count(data, chunk.errorLine, '\n'));
+            std::cerr << "Error: OBJ line " << line << ": " << chunk.errorMessage << std::endl;
+            return false;
+        }
+    }
+
+    // Chunks are merged in file order, so the result matches a serial parse
+    std::vector<size_t> vertexBase(chunks.size());
+    std::vector<size_t> indexBase(chunks.size());
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        vertexBase[i] = vertexCount;
+        indexBase[i] = indexCount;
+        vertexCount += chunks[i].vertices.size();
+        indexCount += chunks[i].indices.size();
+    }
+    if (vertexCount > std::numeric_limits<uint32_t>::max()) {
+        std::cerr << "Error: OBJ has too many vertices for 32-bit indices" << std::endl;
+        return false;
+    }
+    vertices.resize(vertexCount);
+    indices.resize(indexCount);
+
+    std::atomic<bool> inRange{ true };
+    forEachChunk([&](int i) {
+        ObjChunk& chunk = chunks[i];
+        std::copy(chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + vertexBase[i]);
+        for (size_t position : chunk.relative) {
+            int64_t index = int64_t(vertexBase[i]) + static_cast<int32_t>(chunk.indices[position]);
+            chunk.indices[position] = index < 0 ? std::numeric_limits<uint32_t>::max() : static_cast<uint32_t>(index);
+        }
+        uint32_t* out = indices.data() + indexBase[i];
+        for (size_t j = 0; j < chunk.indices.size(); j++) {
+            if (chunk.indices[j] >= vertexCount) inRange.store(false, std::memory_order_relaxed);
+            out[j] = chunk.indices[j];
+        }
+        std::vector<Vec3>().swap(chunk.vertices);
+        std::vector<uint32_t>().swap(chunk.indices);
+    });
+
+    if (!inRange.load()) {
+        std::cerr << "Error: OBJ face refers to a vertex that does not exist" << std::endl;
+        vertices.clear();
+        indices.clear();
+        return false;
+    }
+    return true;
+}
+}
+
+bool ParseOBJ(const char* data, size_t size, std::vector<Vec3>& vertices, std::vector<uint32_t>& indices,
+    ThreadPool* threadPool) {
+    vertices.clear();
+    indices.clear();
+
+    #ifndef __EMSCRIPTEN__
+    if (size >= kParallelParseThreshold) {
+        if (threadPool) {
+            size_t chunkCount = std::clamp<size_t>(size / kMinChunkSize, 1, size_t(4 * std::max(1, threadPool->Size())));
+            std::vector<ObjChunk> chunks = SplitChunks(data, size, chunkCount);
+            return ParseChunks(data, chunks, vertices, indices, threadPool);
+        }
+        ThreadPool temporaryPool(std::max(1u, std::thread::hardware_concurrency()));
+        return ParseOBJ(data, size, vertices, indices, &temporaryPool);
+    }
+    #endif
+
+    std::vector<ObjChunk> chunks = SplitChunks(data, size, 1);
+    return ParseChunks(data, chunks, vertices, indices, nullptr);
+}
+
+bool ParseOBJFile(const std::string& filename, std::vector<Vec3>& vertices, std::vector<uint32_t>& indices,
+    ThreadPool* threadPool) {
+    MappedFile file;
+    if (!file.Open(filename)) {
+        std::cerr << "Error: Could not open OBJ file: " << filename << std::endl;
+        return false;
+    }
+    return ParseOBJ(reinterpret_cast<const char*>(file.Data()), file.Size(), vertices, indices, threadPool);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "core/Vec3.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Reads the geometry of a Wavefront OBJ file: vertex positions ("v x y z [w]") and faces
+// ("f" with v, v/vt, v//vn or v/vt/vn corners, positive or negative indices). Faces with more than three
+// corners are fan-triangulated; every other statement is skipped. Large inputs are split at line
+// boundaries and parsed in parallel on threadPool (a temporary one when null), then merged in file order.
+// vertices and indices are replaced; indices are zero-based, three per triangle.
+// Returns false with a message on std::cerr for malformed or out-of-range data.
+bool ParseOBJ(const char* data, size_t size, std::vector<Vec3>& vertices, std::vector<uint32_t>& indices,
+    ThreadPool* threadPool = nullptr);
+
+// ParseOBJ over a memory-mapped file
+bool ParseOBJFile(const std::string& filename, std::vector<Vec3>& vertices, std::vector<uint32_t>& indices,
+    ThreadPool* threadPool = nullptr);
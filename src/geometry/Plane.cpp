@@ -1,6 +1,8 @@
 #include "geometry/Plane.h"
+#include "utils/RenderStats.h"
 
 bool Plane::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    RT_STAT_INC(StatCounter::OtherPrimitiveTests);
     // Calculate the denominator for the plane equation
     float denominator = ray.direction.Dot(Vec3(0, 1, 0));
     
@@ -31,7 +33,7 @@ bool Plane::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const
     record.point = hitPoint;
     record.normal = Vec3(0, 1, 0);
     record.SetFaceNormal(ray, record.normal);
-    record.material = material;
+    record.materialId = materialId;
     
     return true;
 }
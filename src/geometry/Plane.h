@@ -3,12 +3,12 @@
 
 class Plane : public Hittable {
 public:
-    std::shared_ptr<Material> material;
+    uint32_t materialId;
 
-    Plane() : material(nullptr) {}
+    Plane() : materialId(kNoMaterial) {}
 
-    Plane(std::shared_ptr<Material> material)
-        : material(material) {}
+    Plane(uint32_t materialId)
+        : materialId(materialId) {}
 
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
 
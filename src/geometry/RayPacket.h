@@ -0,0 +1,81 @@
+#pragma once
+#include "geometry/Hittable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Group of up to 64 coherent rays (an 8x8 pixel tile of primary rays) traced together.
+// Rays are added with Add, then Finalize computes the interval bounds used to cull
+// BVH nodes for the whole packet at once.
+struct RayPacket {
+    static constexpr int kMaxSize = 64;
+
+    Ray rays[kMaxSize];
+    Vec3A invDir[kMaxSize];
+    float tMax[kMaxSize];
+    HitRecord records[kMaxSize];
+    bool hit[kMaxSize];
+    int size = 0;
+
+    // Per-axis ranges of origins and reciprocal directions over all rays
+    float originMin[3], originMax[3];
+    float invDirMin[3], invDirMax[3];
+    float maxT = 0.0f;
+    // Every ray's direction has the same sign per axis, so the interval test is valid
+    bool coherent = false;
+
+    void Add(const Ray& ray, float rayTMax) {
+        rays[size] = ray;
+        invDir[size] = ray.direction.Reciprocal();
+        tMax[size] = rayTMax;
+        hit[size] = false;
+        size++;
+    }
+
+    void Finalize() {
+        coherent = size > 0;
+        for (int a = 0; a < 3; a++) {
+            originMin[a] = invDirMin[a] = std::numeric_limits<float>::infinity();
+            originMax[a] = invDirMax[a] = -std::numeric_limits<float>::infinity();
+            for (int i = 0; i < size; i++) {
+                originMin[a] = std::min(originMin[a], rays[i].origin[a]);
+                originMax[a] = std::max(originMax[a], rays[i].origin[a]);
+                invDirMin[a] = std::min(invDirMin[a], invDir[i][a]);
+                invDirMax[a] = std::max(invDirMax[a], invDir[i][a]);
+            }
+            bool sameSign = invDirMin[a] > 0.0f || invDirMax[a] < 0.0f;
+            if (!sameSign || !std::isfinite(invDirMin[a]) || !std::isfinite(invDirMax[a])) coherent = false;
+        }
+        UpdateMaxT();
+    }
+
+    void UpdateMaxT() {
+        maxT = 0.0f;
+        for (int i = 0; i < size; i++) maxT = std::max(maxT, tMax[i]);
+    }
+
+    // Conservative interval-arithmetic slab test: false only if every ray misses the box.
+    // Only valid for coherent packets.
+    bool IntervalHit(const float* boundsMin, const float* boundsMax, float tMin) const {
+        float nearT = tMin;
+        float farT = maxT;
+        for (int a = 0; a < 3; a++) {
+            bool negative = invDirMax[a] < 0.0f;
+            float nearPlane = negative ? boundsMax[a] : boundsMin[a];
+            float farPlane = negative ? boundsMin[a] : boundsMax[a];
+
+            float n0 = (nearPlane - originMax[a]) * invDirMin[a];
+            float n1 = (nearPlane - originMax[a]) * invDirMax[a];
+            float n2 = (nearPlane - originMin[a]) * invDirMin[a];
+            float n3 = (nearPlane - originMin[a]) * invDirMax[a];
+            nearT = std::max(nearT, std::min(std::min(n0, n1), std::min(n2, n3)));
+
+            float f0 = (farPlane - originMax[a]) * invDirMin[a];
+            float f1 = (farPlane - originMax[a]) * invDirMax[a];
+            float f2 = (farPlane - originMin[a]) * invDirMin[a];
+            float f3 = (farPlane - originMin[a]) * invDirMax[a];
+            farT = std::min(farT, std::max(std::max(f0, f1), std::max(f2, f3)));
+        }
+        return nearT <= farT;
+    }
+};
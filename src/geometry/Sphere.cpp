@@ -1,9 +1,11 @@
 #include "geometry/Sphere.h"
+#include "utils/RenderStats.h"
 #include <cmath>
 
 bool Sphere::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    RT_STAT_INC(StatCounter::SphereTests);
     // Calculate coefficients for the quadratic equation
-    Vec3 oc = ray.origin;
+    const Vec3A& oc = ray.origin;
     float a = ray.direction.LengthSquared();
     float half_b = oc.Dot(ray.direction);
     float c = oc.LengthSquared() - 1;
@@ -29,9 +31,9 @@ bool Sphere::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) cons
     // Record the hit information
     record.t = root;
     record.point = ray.At(record.t);
-    Vec3 outward_normal = record.point;
+    Vec3A outward_normal = record.point;
     record.SetFaceNormal(ray, outward_normal);
-    record.material = material;
+    record.materialId = materialId;
     
     return true;
 }
@@ -3,12 +3,12 @@
 
 class Sphere : public Hittable {
 public:
-    std::shared_ptr<Material> material;
+    uint32_t materialId;
 
     // Constructors
-    Sphere() : material(nullptr) {}
-    Sphere(std::shared_ptr<Material> material) 
-        : material(material) {}
+    Sphere() : materialId(kNoMaterial) {}
+    Sphere(uint32_t materialId)
+        : materialId(materialId) {}
 
     // Ray intersection implementation
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
@@ -4,13 +4,7 @@
 
 void Transform::UpdateMatrices() const {
     if (matricesDirty) {
-        Matrix4x4 translationMatrix = Matrix4x4::Translation(position);
-        Matrix4x4 rotationMatrix = Matrix4x4::Rotation(rotation);
-        Matrix4x4 scaleMatrix = Matrix4x4::Scaling(scale);
-
-        transformMatrix = translationMatrix * rotationMatrix * scaleMatrix;
-
-        inverseMatrix = transformMatrix.Inverse();
+        placement = ObjectTransform(AffineTransform::Compose(position, rotation, scale));
 
         matricesDirty = false;
     }
@@ -39,34 +33,9 @@ void Transform::SetTransform(const Vec3& pos, const Vec3& rot, const Vec3& scl)
 }
 
 bool Transform::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
-    UpdateMatrices();
-
-    // Transform the ray into the local space of the object
-    Vec3 transformedOrigin = inverseMatrix.TransformPoint(ray.origin);
-    Vec3 transformedDirection = inverseMatrix.TransformDirection(ray.direction);
-    
-    // Store the length before normalizing
-    float dirLength = transformedDirection.Length();
-    transformedDirection = transformedDirection.Normalize();
-    
-    Ray transformedRay(transformedOrigin, transformedDirection);
-
-    // Adjust tMin and tMax to account for scaling
-    float adjustedTMin = tMin * dirLength;
-    float adjustedTMax = tMax * dirLength;
-
-    if (!object->Hit(transformedRay, adjustedTMin, adjustedTMax, record)) {
-        return false;
-    }
-    
-    // Transform the hit record back to world space
-    record.point = transformMatrix.TransformPoint(record.point);
-    record.normal = inverseMatrix.Transpose().TransformDirection(record.normal).Normalize();
-    
-    // Double-check the t value with projection
-    record.t = (record.point - ray.origin).Length();
-    
-    return true;
+    return HitWith(ray, tMin, tMax, record, [this](const Ray& localRay, float t0, float t1, HitRecord& rec) {
+        return object->Hit(localRay, t0, t1, rec);
+    });
 }
 
 bool Transform::BoundingBox(AABB& outputBox) const {
@@ -97,7 +66,7 @@ bool Transform::BoundingBox(AABB& outputBox) const {
     Vec3 newMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 
     for (const auto& corner : corners) {
-        Vec3 transformedCorner = transformMatrix.TransformPoint(corner);
+        Vec3 transformedCorner = placement.objectToWorld.TransformPoint(corner);
         newMin.x = std::min(newMin.x, transformedCorner.x);
         newMin.y = std::min(newMin.y, transformedCorner.y);
         newMin.z = std::min(newMin.z, transformedCorner.z);
@@ -1,7 +1,8 @@
 #pragma once
 #include "geometry/Hittable.h"
 #include "core/Vec3.h"
-#include "core/Matrix4x4.h"
+#include "core/AffineTransform.h"
+#include <memory>
 
 class Transform : public Hittable {
 private:
@@ -11,11 +12,8 @@ private:
     Vec3 rotation;
     Vec3 scale;
 
-    mutable Matrix4x4 transformMatrix;
-    mutable Matrix4x4 inverseMatrix;
+    mutable ObjectTransform placement;
     mutable bool matricesDirty;
-
-    void UpdateMatrices() const;
 public:
     Transform(std::shared_ptr<Hittable> obj) 
         : object(obj), 
@@ -32,8 +30,31 @@ public:
     Vec3 GetPosition() const { return position; }
     Vec3 GetRotation() const { return rotation; }
     Vec3 GetScale() const { return scale; }
+    std::shared_ptr<Hittable> GetObject() const { return object; }
+
+    // Recomputes the matrices after a setter; Hit does it lazily, which is not safe to race on
+    void UpdateMatrices() const;
 
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& rec) const override;
 
+    // Hit with the local-space test supplied by the caller, hitObject(localRay, tMin, tMax, record), so
+    // compiled scenes can reach the wrapped object without a virtual call
+    template <typename HitObject>
+    bool HitWith(const Ray& ray, float tMin, float tMax, HitRecord& record, HitObject&& hitObject) const;
+
     virtual bool BoundingBox(AABB& outputBox) const override;
 };
+
+template <typename HitObject>
+bool Transform::HitWith(const Ray& ray, float tMin, float tMax, HitRecord& record, HitObject&& hitObject) const {
+    UpdateMatrices();
+
+    // The local direction keeps its length, so t is the same parameter in both spaces and needs no rescaling
+    if (!hitObject(placement.ToObject(ray), tMin, tMax, record)) {
+        return false;
+    }
+
+    record.point = placement.PointToWorld(record.point);
+    record.normal = placement.NormalToWorld(record.normal);
+    return true;
+}
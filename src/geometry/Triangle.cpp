@@ -1,33 +1,16 @@
 #include "geometry/Triangle.h"
+#include "utils/RenderStats.h"
 
 bool Triangle::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
-    Vec3 h = ray.direction.Cross(e2);
-    float a = e1.Dot(h);
-
-    if (abs(a) < 1e-8) 
-        return false;
-    
-    float f = 1.0f / a;
-    Vec3 s = ray.origin - v0;
-    float u = f * s.Dot(h);
-
-    if (u < 0.0f || u > 1.0f)
-        return false;
-    
-    Vec3 q = s.Cross(e1);
-    float v = f * ray.direction.Dot(q);
-
-    if (v < 0.0f || u + v > 1.0f)
-        return false;
-
-    float t = f * e2.Dot(q);
-    if (t < tMin || t > tMax)
+    RT_STAT_INC(StatCounter::TriangleTests);
+    float t;
+    if (!Intersect(v0, e1, e2, ray, tMin, tMax, t))
         return false;
 
     record.t = t;
     record.point = ray.At(t);
     record.normal = normal;
-    record.material = material;
+    record.materialId = materialId;
 
     return true;
 }
@@ -37,6 +20,13 @@ bool Triangle::BoundingBox(AABB& outputBox) const {
         outputBox = boundingBox;
         return true;
     }
+    outputBox = Bounds(v0, v1, v2);
+    boundingBox = outputBox;
+    boundingBoxCached = true;
+    return true;
+}
+
+AABB Triangle::Bounds(const Vec3A& v0, const Vec3A& v1, const Vec3A& v2) {
     // Find min and max for each dimension
     float minX = std::min(std::min(v0.x, v1.x), v2.x);
     float minY = std::min(std::min(v0.y, v1.y), v2.y);
@@ -61,9 +51,5 @@ bool Triangle::BoundingBox(AABB& outputBox) const {
         minZ -= epsilon * 0.5f;
     }
     
-    // Create the bounding box
-    outputBox = AABB(Vec3(minX, minY, minZ), Vec3(maxX, maxY, maxZ));
-    boundingBox = outputBox;
-    boundingBoxCached = true;
-    return true;
+    return AABB(Vec3(minX, minY, minZ), Vec3(maxX, maxY, maxZ));
 }
\ No newline at end of file
@@ -1,22 +1,51 @@
 #pragma once
 #include "geometry/Hittable.h"
 
-class Triangle : public Hittable {
+class Triangle final : public Hittable {
 private:
-    Vec3 e1, e2, normal;
+    Vec3A e1, e2, normal;
 public:
-    Vec3 v0, v1, v2;
-    std::shared_ptr<Material> material;
+    Vec3A v0, v1, v2;
+    uint32_t materialId;
 
-    Triangle() : material(nullptr) {}
-    Triangle(const Vec3& v0, const Vec3& v1, const Vec3& v2, std::shared_ptr<Material> material)
-        : v0(v0), v1(v1), v2(v2), material(material) {
+    Triangle() : materialId(kNoMaterial) {}
+    Triangle(const Vec3& v0, const Vec3& v1, const Vec3& v2, uint32_t materialId)
+        : v0(v0), v1(v1), v2(v2), materialId(materialId) {
             e1 = v1 - v0;
             e2 = v2 - v0;
-            normal = e1.Cross(e2).Normalize();
+            // Checked Vec3 math: a degenerate triangle throws here, at authoring time, not during a render
+            normal = (v1 - v0).Cross(v2 - v0).Normalize();
         }
 
+    // Möller–Trumbore test against the triangle (v0, v0 + e1, v0 + e2); writes t on a hit
+    static bool Intersect(const Vec3A& v0, const Vec3A& e1, const Vec3A& e2, const Ray& ray, float tMin, float tMax, float& t) {
+        Vec3A h = ray.direction.Cross(e2);
+        float a = e1.Dot(h);
+
+        if (std::abs(a) < 1e-8) 
+            return false;
+        
+        float f = 1.0f / a;
+        Vec3A s = ray.origin - v0;
+        float u = f * s.Dot(h);
+
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        
+        Vec3A q = s.Cross(e1);
+        float v = f * ray.direction.Dot(q);
+
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+
+        t = f * e2.Dot(q);
+        return t >= tMin && t <= tMax;
+    }
+
+    // Bounds padded so that axis-aligned triangles never get a zero-thickness box
+    static AABB Bounds(const Vec3A& v0, const Vec3A& v1, const Vec3A& v2);
+
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
 
     virtual bool BoundingBox(AABB& outputBox) const override;
-};
\ No newline at end of file
+};
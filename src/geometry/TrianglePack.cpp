@@ -0,0 +1,161 @@
+#include "geometry/TrianglePack.h"
+#include "geometry/Triangle.h"
+#include <limits>
+
+namespace {
+// Each kernel writes the lane's hit distance, or infinity on a miss, into tLane
+
+template <int Width>
+void IntersectLanesScalar(const TrianglePack<Width>& pack, const Ray& ray, float tMin, float tMax, float* tLane) {
+    for (uint32_t lane = 0; lane < pack.count; lane++) {
+        Vec3 v0(pack.v0[0][lane], pack.v0[1][lane], pack.v0[2][lane]);
+        Vec3 e1(pack.e1[0][lane], pack.e1[1][lane], pack.e1[2][lane]);
+        Vec3 e2(pack.e2[0][lane], pack.e2[1][lane], pack.e2[2][lane]);
+        float t;
+        tLane[lane] = Triangle::Intersect(v0, e1, e2, ray, tMin, tMax, t) ? t : std::numeric_limits<float>::infinity();
+    }
+}
+
+#if defined(RT_SIMD_X86)
+// Same operation order as Triangle::Intersect, so hits match the scalar test exactly
+template <int Width>
+void IntersectLanesSSE(const TrianglePack<Width>& pack, const Ray& ray, float tMin, float tMax, float* tLane) {
+    const __m128 dx = _mm_set1_ps(ray.direction.x);
+    const __m128 dy = _mm_set1_ps(ray.direction.y);
+    const __m128 dz = _mm_set1_ps(ray.direction.z);
+    const __m128 ox = _mm_set1_ps(ray.origin.x);
+    const __m128 oy = _mm_set1_ps(ray.origin.y);
+    const __m128 oz = _mm_set1_ps(ray.origin.z);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(1e-8f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 minT = _mm_set1_ps(tMin);
+    const __m128 maxT = _mm_set1_ps(tMax);
+
+    for (int base = 0; base < Width; base += 4) {
+        __m128 e1x = _mm_load_ps(&pack.e1[0][base]);
+        __m128 e1y = _mm_load_ps(&pack.e1[1][base]);
+        __m128 e1z = _mm_load_ps(&pack.e1[2][base]);
+        __m128 e2x = _mm_load_ps(&pack.e2[0][base]);
+        __m128 e2y = _mm_load_ps(&pack.e2[1][base]);
+        __m128 e2z = _mm_load_ps(&pack.e2[2][base]);
+
+        __m128 hx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 hy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 hz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, hx), _mm_mul_ps(e1y, hy)), _mm_mul_ps(e1z, hz));
+        __m128 f = _mm_div_ps(one, a);
+
+        __m128 sx = _mm_sub_ps(ox, _mm_load_ps(&pack.v0[0][base]));
+        __m128 sy = _mm_sub_ps(oy, _mm_load_ps(&pack.v0[1][base]));
+        __m128 sz = _mm_sub_ps(oz, _mm_load_ps(&pack.v0[2][base]));
+        __m128 u = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, hx), _mm_mul_ps(sy, hy)), _mm_mul_ps(sz, hz)));
+
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 v = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)));
+        __m128 t = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)));
+
+        __m128 mask = _mm_cmpgt_ps(_mm_andnot_ps(signMask, a), epsilon);
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(u, one));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(t, minT));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(t, maxT));
+
+        _mm_storeu_ps(tLane + base, _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, inf)));
+    }
+}
+
+RT_TARGET_AVX2
+void IntersectLanesAVX2(const TrianglePack<8>& pack, const Ray& ray, float tMin, float tMax, float* tLane) {
+    const __m256 dx = _mm256_set1_ps(ray.direction.x);
+    const __m256 dy = _mm256_set1_ps(ray.direction.y);
+    const __m256 dz = _mm256_set1_ps(ray.direction.z);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 e1x = _mm256_load_ps(pack.e1[0]);
+    __m256 e1y = _mm256_load_ps(pack.e1[1]);
+    __m256 e1z = _mm256_load_ps(pack.e1[2]);
+    __m256 e2x = _mm256_load_ps(pack.e2[0]);
+    __m256 e2y = _mm256_load_ps(pack.e2[1]);
+    __m256 e2z = _mm256_load_ps(pack.e2[2]);
+
+    __m256 hx = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+    __m256 hy = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+    __m256 hz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+    __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, hx), _mm256_mul_ps(e1y, hy)), _mm256_mul_ps(e1z, hz));
+    __m256 f = _mm256_div_ps(one, a);
+
+    __m256 sx = _mm256_sub_ps(_mm256_set1_ps(ray.origin.x), _mm256_load_ps(pack.v0[0]));
+    __m256 sy = _mm256_sub_ps(_mm256_set1_ps(ray.origin.y), _mm256_load_ps(pack.v0[1]));
+    __m256 sz = _mm256_sub_ps(_mm256_set1_ps(ray.origin.z), _mm256_load_ps(pack.v0[2]));
+    __m256 u = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, hx), _mm256_mul_ps(sy, hy)), _mm256_mul_ps(sz, hz)));
+
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+    __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+    __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+    __m256 v = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)));
+    __m256 t = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)));
+
+    __m256 absA = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+    __m256 mask = _mm256_cmp_ps(absA, _mm256_set1_ps(1e-8f), _CMP_GT_OQ);
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, _mm256_setzero_ps(), _CMP_GE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, one, _CMP_LE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(tMin), _CMP_GE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(tMax), _CMP_LE_OQ));
+
+    _mm256_storeu_ps(tLane, _mm256_blendv_ps(_mm256_set1_ps(std::numeric_limits<float>::infinity()), t, mask));
+}
+#endif
+
+template <int Width>
+int NearestLane(const TrianglePack<Width>& pack, const float* tLane, float& t) {
+    int nearest = -1;
+    float nearestT = std::numeric_limits<float>::infinity();
+    for (uint32_t lane = 0; lane < pack.count; lane++) {
+        if (tLane[lane] < nearestT) {
+            nearestT = tLane[lane];
+            nearest = static_cast<int>(lane);
+        }
+    }
+    if (nearest >= 0) t = nearestT;
+    return nearest;
+}
+}
+
+template <>
+int IntersectTrianglePack<4>(const TrianglePack<4>& pack, const Ray& ray, float tMin, float tMax, float& t) {
+    alignas(16) float tLane[4];
+#if defined(RT_SIMD_X86)
+    if (ActiveSimdLevel() != SimdLevel::Scalar) {
+        IntersectLanesSSE(pack, ray, tMin, tMax, tLane);
+        return NearestLane(pack, tLane, t);
+    }
+#endif
+    IntersectLanesScalar(pack, ray, tMin, tMax, tLane);
+    return NearestLane(pack, tLane, t);
+}
+
+template <>
+int IntersectTrianglePack<8>(const TrianglePack<8>& pack, const Ray& ray, float tMin, float tMax, float& t) {
+    alignas(32) float tLane[8];
+#if defined(RT_SIMD_X86)
+    if (ActiveSimdLevel() == SimdLevel::AVX2) {
+        IntersectLanesAVX2(pack, ray, tMin, tMax, tLane);
+        return NearestLane(pack, tLane, t);
+    }
+    if (ActiveSimdLevel() == SimdLevel::SSE) {
+        IntersectLanesSSE(pack, ray, tMin, tMax, tLane);
+        return NearestLane(pack, tLane, t);
+    }
+#endif
+    IntersectLanesScalar(pack, ray, tMin, tMax, tLane);
+    return NearestLane(pack, tLane, t);
+}
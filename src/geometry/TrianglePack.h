@@ -0,0 +1,24 @@
+#pragma once
+#include "core/Ray.h"
+#include "core/Simd.h"
+#include <cstdint>
+
+// Up to Width triangles of one BVH leaf in structure-of-arrays form, so a
+// single SIMD Möller–Trumbore pass tests all of them
+template <int Width>
+struct alignas(32) TrianglePack {
+    float v0[3][Width];
+    float e1[3][Width];
+    float e2[3][Width];
+    uint32_t triangle[Width]; // Mesh triangle index per lane
+    uint32_t count;           // Triangles occupy the first count lanes
+};
+
+// Returns the lane of the nearest hit within [tMin, tMax] and writes its distance to t, or -1 on a miss
+template <int Width>
+int IntersectTrianglePack(const TrianglePack<Width>& pack, const Ray& ray, float tMin, float tMax, float& t);
+
+// Pack width matching the widest SIMD kernel the CPU runs
+inline int PreferredTrianglePackWidth() {
+    return ActiveSimdLevel() == SimdLevel::AVX2 ? 8 : 4;
+}
@@ -0,0 +1,148 @@
+#include "geometry/WideBVH.h"
+
+uint32_t WideSlabTestScalar(const float* bounds, int width, const WideBVHRay& ray, float tMin, float tMax, float* tNear) {
+    uint32_t mask = 0;
+    for (int lane = 0; lane < width; lane++) {
+        float laneNear = tMin;
+        float laneFar = tMax;
+        for (int a = 0; a < 3; a++) {
+            float t0 = (bounds[ray.nearPlane[a] * width + lane] - ray.origin[a]) * ray.invDir[a];
+            float t1 = (bounds[ray.farPlane[a] * width + lane] - ray.origin[a]) * ray.invDir[a];
+            // Written so that a NaN slab (0 * inf) leaves the interval unchanged
+            laneNear = t0 > laneNear ? t0 : laneNear;
+            laneFar = t1 < laneFar ? t1 : laneFar;
+        }
+        tNear[lane] = laneNear;
+        if (laneNear <= laneFar) mask |= 1u << lane;
+    }
+    return mask;
+}
+
+#if defined(RT_SIMD_X86)
+uint32_t WideSlabTestSSE(const float* bounds, int width, const WideBVHRay& ray, float tMin, float tMax, float* tNear) {
+    uint32_t mask = 0;
+    for (int base = 0; base < width; base += 4) {
+        __m128 laneNear = _mm_set1_ps(tMin);
+        __m128 laneFar = _mm_set1_ps(tMax);
+        for (int a = 0; a < 3; a++) {
+            __m128 origin = _mm_set1_ps(ray.origin[a]);
+            __m128 invDir = _mm_set1_ps(ray.invDir[a]);
+            __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds + ray.nearPlane[a] * width + base), origin), invDir);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds + ray.farPlane[a] * width + base), origin), invDir);
+            // max/min return the second operand for NaN inputs, matching the scalar kernel
+            laneNear = _mm_max_ps(t0, laneNear);
+            laneFar = _mm_min_ps(t1, laneFar);
+        }
+        _mm_storeu_ps(tNear + base, laneNear);
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(laneNear, laneFar))) << base;
+    }
+    return mask;
+}
+
+RT_TARGET_AVX2
+uint32_t WideSlabTestAVX2(const float* bounds, int width, const WideBVHRay& ray, float tMin, float tMax, float* tNear) {
+    uint32_t mask = 0;
+    for (int base = 0; base < width; base += 8) {
+        __m256 laneNear = _mm256_set1_ps(tMin);
+        __m256 laneFar = _mm256_set1_ps(tMax);
+        for (int a = 0; a < 3; a++) {
+            __m256 origin = _mm256_set1_ps(ray.origin[a]);
+            __m256 invDir = _mm256_set1_ps(ray.invDir[a]);
+            __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds + ray.nearPlane[a] * width + base), origin), invDir);
+            __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds + ray.farPlane[a] * width + base), origin), invDir);
+            laneNear = _mm256_max_ps(t0, laneNear);
+            laneFar = _mm256_min_ps(t1, laneFar);
+        }
+        _mm256_storeu_ps(tNear + base, laneNear);
+        mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(laneNear, laneFar, _CMP_LE_OQ))) << base;
+    }
+    return mask;
+}
+#endif
+
+WideSlabTest SelectWideSlabTest(int width) {
+#if defined(RT_SIMD_X86)
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::AVX2:
+            if (width % 8 == 0) return WideSlabTestAVX2;
+            return WideSlabTestSSE;
+        case SimdLevel::SSE:
+            return WideSlabTestSSE;
+        default:
+            break;
+    }
+#endif
+    return WideSlabTestScalar;
+}
+
+template <int Width>
+void WideBVH<Width>::Build(const LinearBVH& binary) {
+    Clear();
+    if (binary.Empty()) return;
+
+    primitiveIndices = binary.GetPrimitiveIndices();
+    nodes.reserve(binary.GetNodes().size() / (Width - 1) + 1);
+    Collapse(binary, 0);
+    nodes.shrink_to_fit();
+}
+
+template <int Width>
+uint32_t WideBVH<Width>::Collapse(const LinearBVH& binary, uint32_t binaryIndex) {
+    const std::vector<LinearBVHNode>& binaryNodes = binary.GetNodes();
+    const LinearBVHNode& binaryNode = binaryNodes[binaryIndex];
+
+    uint32_t candidates[Width];
+    int candidateCount = 0;
+    if (binaryNode.primitiveCount > 0) {
+        candidates[candidateCount++] = binaryIndex;
+    } else {
+        candidates[candidateCount++] = binaryIndex + 1;
+        candidates[candidateCount++] = binaryNode.offset;
+    }
+
+    // Open the interior candidate with the largest surface area until the node is full
+    while (candidateCount < Width) {
+        int best = -1;
+        float bestArea = -1.0f;
+        for (int i = 0; i < candidateCount; i++) {
+            const LinearBVHNode& candidate = binaryNodes[candidates[i]];
+            if (candidate.primitiveCount > 0) continue;
+            float area = SurfaceArea(candidate);
+            if (area > bestArea) {
+                bestArea = area;
+                best = i;
+            }
+        }
+        if (best < 0) break;
+
+        uint32_t opened = candidates[best];
+        candidates[best] = opened + 1;
+        candidates[candidateCount++] = binaryNodes[opened].offset;
+    }
+
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    WideBVHNode<Width> node = {};
+    node.childCount = static_cast<uint32_t>(candidateCount);
+    for (int lane = 0; lane < candidateCount; lane++) {
+        const LinearBVHNode& candidate = binaryNodes[candidates[lane]];
+        for (int a = 0; a < 3; a++) {
+            node.bounds[a][lane] = candidate.boundsMin[a];
+            node.bounds[a + 3][lane] = candidate.boundsMax[a];
+        }
+        if (candidate.primitiveCount > 0) {
+            node.child[lane] = candidate.offset;
+            node.count[lane] = candidate.primitiveCount;
+        } else {
+            node.child[lane] = Collapse(binary, candidates[lane]);
+            node.count[lane] = 0;
+        }
+    }
+
+    nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+template class WideBVH<4>;
+template class WideBVH<8>;
@@ -0,0 +1,134 @@
+#pragma once
+#include "geometry/LinearBVH.h"
+#include "core/Simd.h"
+#include "utils/RenderStats.h"
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+// Node with up to Width children whose boxes are stored as structure-of-arrays,
+// so one SIMD slab test covers every child
+template <int Width>
+struct alignas(32) WideBVHNode {
+    float bounds[6][Width]; // minX, minY, minZ, maxX, maxY, maxZ for each child
+    uint32_t child[Width];  // Interior child: node index, leaf child: first entry in primitiveIndices
+    uint16_t count[Width];  // Primitives in a leaf child, 0 for interior children
+    uint32_t childCount;    // Children occupy the first childCount lanes
+};
+
+// Ray data shared by every slab test of a traversal
+struct WideBVHRay {
+    float origin[3];
+    float invDir[3];
+    int nearPlane[3]; // Row of WideBVHNode::bounds holding the entry plane per axis
+    int farPlane[3];
+};
+
+// Tests the ray against `width` SoA boxes and returns a bitmask of hit lanes, writing entry distances to tNear
+using WideSlabTest = uint32_t (*)(const float* bounds, int width, const WideBVHRay& ray, float tMin, float tMax, float* tNear);
+
+uint32_t WideSlabTestScalar(const float* bounds, int width, const WideBVHRay& ray, float tMin, float tMax, float* tNear);
+#if defined(RT_SIMD_X86)
+uint32_t WideSlabTestSSE(const float* bounds, int width, const WideBVHRay& ray, float tMin, float tMax, float* tNear);
+uint32_t WideSlabTestAVX2(const float* bounds, int width, const WideBVHRay& ray, float tMin, float tMax, float* tNear);
+#endif
+
+// Picks the kernel for the active SIMD level; AVX2 needs all 8 lanes of a BVH8 node
+WideSlabTest SelectWideSlabTest(int width);
+
+// BVH4 / BVH8 collapsed from a binary LinearBVH, traversed nearest child first
+template <int Width>
+class WideBVH {
+private:
+    std::vector<WideBVHNode<Width>> nodes;
+    std::vector<uint32_t> primitiveIndices;
+
+    uint32_t Collapse(const LinearBVH& binary, uint32_t binaryIndex);
+public:
+    void Build(const LinearBVH& binary);
+    void Clear() {
+        nodes.clear();
+        primitiveIndices.clear();
+    }
+
+    bool Empty() const { return nodes.empty(); }
+    size_t GetMemoryUsage() const {
+        return nodes.capacity() * sizeof(WideBVHNode<Width>) + primitiveIndices.capacity() * sizeof(uint32_t);
+    }
+
+    // Same contract as LinearBVH::Hit
+    template <typename HitPrimitive>
+    bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record, HitPrimitive&& hitPrimitive) const {
+        if (nodes.empty()) return false;
+
+        WideBVHRay wideRay;
+        const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+        const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+        for (int a = 0; a < 3; a++) {
+            wideRay.origin[a] = origin[a];
+            wideRay.invDir[a] = 1.0f / direction[a];
+            bool negative = wideRay.invDir[a] < 0.0f;
+            wideRay.nearPlane[a] = negative ? a + 3 : a;
+            wideRay.farPlane[a] = negative ? a : a + 3;
+        }
+
+        WideSlabTest slabTest = SelectWideSlabTest(Width);
+
+        struct StackEntry {
+            uint32_t child;
+            uint32_t count;
+            float tNear;
+        };
+        // A collapsed tree is no deeper than its binary tree (kMaxBVHDepth), and each level leaves at
+        // most Width - 1 siblings pending
+        StackEntry stack[kBVHTraversalStackSize * Width];
+        int stackSize = 0;
+        stack[stackSize++] = StackEntry{ 0, 0, tMin };
+        bool hitAnything = false;
+        LocalStats stats;
+
+        while (stackSize > 0) {
+            StackEntry entry = stack[--stackSize];
+            if (entry.tNear > tMax) continue;
+
+            if (entry.count > 0) {
+                for (uint32_t i = 0; i < entry.count; i++) {
+                    if (hitPrimitive(primitiveIndices[entry.child + i], ray, tMin, tMax, record)) {
+                        hitAnything = true;
+                        tMax = record.t;
+                    }
+                }
+                continue;
+            }
+
+            const WideBVHNode<Width>& node = nodes[entry.child];
+            stats.Add(StatCounter::NodeVisits);
+            stats.Add(StatCounter::AABBTests, node.childCount);
+            alignas(32) float tNear[Width];
+            uint32_t mask = slabTest(&node.bounds[0][0], Width, wideRay, tMin, tMax, tNear);
+            mask &= (1u << node.childCount) - 1u;
+
+            // Push hit children farthest first so the nearest is popped next
+            int first = stackSize;
+            while (mask) {
+                int lane = 0;
+                while (!(mask & (1u << lane))) lane++;
+                mask &= mask - 1u;
+
+                StackEntry child{ node.child[lane], node.count[lane], tNear[lane] };
+                assert(stackSize < kBVHTraversalStackSize * Width);
+                int j = stackSize++;
+                while (j > first && stack[j - 1].tNear < child.tNear) {
+                    stack[j] = stack[j - 1];
+                    j--;
+                }
+                stack[j] = child;
+            }
+        }
+
+        return hitAnything;
+    }
+};
+
+extern template class WideBVH<4>;
+extern template class WideBVH<8>;
@@ -1,23 +1,24 @@
 #include "materials/Dielectric.h"
+#include "core/Sampler.h"
 
 bool Dielectric::Scatter(
     const Ray& rayIn,
     const HitRecord& rec,
-    Vec3& attenuation,
+    Vec3A& attenuation,
     Ray& scattered
 ) const {
-    attenuation = Vec3(1.0f, 1.0f, 1.0f);
+    attenuation = Vec3A(1.0f, 1.0f, 1.0f);
 
     float refractionRatio = rec.frontFace ? (1.0f / refractiveIndex) : refractiveIndex;
 
-    Vec3 unitDirection = rayIn.direction.Normalize();
+    Vec3A unitDirection = rayIn.direction.Normalize();
     float cosTheta = std::fmin((unitDirection * -1).Dot(rec.normal), 1.0f);
     float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
 
     bool cannotRefract = refractionRatio * sinTheta > 1.0f;
-    Vec3 direction;
+    Vec3A direction;
 
-    if (cannotRefract || Reflectance(cosTheta, refractionRatio) > RandomFloat()) {
+    if (cannotRefract || Reflectance(cosTheta, refractionRatio) > SampleNext1D()) {
         direction = unitDirection.Reflect(rec.normal);
     } else {
         direction = unitDirection.Refract(rec.normal, refractionRatio);
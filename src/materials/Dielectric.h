@@ -8,10 +8,12 @@ public:
 
     Dielectric(float ri) : refractiveIndex(ri) {}
 
+    virtual MaterialType Type() const override { return MaterialType::Dielectric; }
+
     virtual bool Scatter(
         const Ray& rayIn,
         const HitRecord& rec,
-        Vec3& attenuation,
+        Vec3A& attenuation,
         Ray& scattered
     ) const override;
 private:
@@ -3,7 +3,7 @@
 bool Emissive::Scatter(
     const Ray& rayIn,
     const HitRecord& hitRecord,
-    Vec3& attenuation,
+    Vec3A& attenuation,
     Ray& scattered
 ) const {
     attenuation = albedo * (1 + emissivity) * 2.0f;
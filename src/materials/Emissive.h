@@ -3,12 +3,14 @@
 
 class Emissive : public Material {
 public:
-    Vec3 albedo;
+    Vec3A albedo;
     float emissivity;
 
     Emissive(const Vec3& albedo, float emissivity)
         : albedo(albedo), emissivity(emissivity) {}
 
-    virtual bool Scatter(const Ray& rayIn, const HitRecord& hitRecord, Vec3& attenuation, Ray& scattered) const override;
+    virtual MaterialType Type() const override { return MaterialType::Emissive; }
+
+    virtual bool Scatter(const Ray& rayIn, const HitRecord& hitRecord, Vec3A& attenuation, Ray& scattered) const override;
 };
     
\ No newline at end of file
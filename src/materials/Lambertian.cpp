@@ -1,4 +1,5 @@
 #include "materials/Lambertian.h"
+#include "core/Sampler.h"
 
 
 Lambertian::Lambertian(const Vec3& albedo) : albedo(albedo) {}
@@ -6,15 +7,13 @@ Lambertian::Lambertian(const Vec3& albedo) : albedo(albedo) {}
 bool Lambertian::Scatter(
     const Ray& rayIn,
     const HitRecord& rec,
-    Vec3& attenuation,
+    Vec3A& attenuation,
     Ray& scattered
 ) const {
-    // Get a random scatter direction
-    Vec3 scatterDirection = rec.normal + RandomUnitVector();
-    
-    // Catch degenerate scatter direction
-    if (scatterDirection.LengthSquared() < 1e-8)
-        scatterDirection = rec.normal;
+    // Cosine-weighted scatter direction, sampled directly instead of by rejection
+    float u, v;
+    SampleNext2D(u, v);
+    Vec3A scatterDirection = SampleCosineHemisphere(rec.normal, u, v);
         
     // Create the scattered ray
     scattered = Ray(rec.point, scatterDirection);
@@ -2,15 +2,26 @@
 #include "core/Ray.h"
 #include "geometry/Hittable.h"
 
+// Concrete material class, so the wavefront integrator can group hits by type and shade without virtual calls
+enum class MaterialType {
+    Lambertian,
+    Metal,
+    Dielectric,
+    Emissive,
+    Other
+};
+
 class Material {
 public:
     virtual ~Material() = default;
 
+    virtual MaterialType Type() const { return MaterialType::Other; }
+
     // Core method to determine how light interacts with the surface
     virtual bool Scatter(
         const Ray& rayIn,
         const HitRecord& rec,
-        Vec3& attenuation,
+        Vec3A& attenuation,
         Ray& scattered
     ) const = 0;
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "materials/MaterialTable.h"
+
+uint32_t MaterialTable::Add(std::shared_ptr<Material> material) {
+    if (!material) return kNoMaterial;
+    auto found = ids.find(material.get());
+    if (found != ids.end()) return found->second;
+
+    uint32_t id = static_cast<uint32_t>(materials.size());
+    ids[material.get()] = id;
+    materials.push_back(material.get());
+    types.push_back(material->Type());
+    owned.push_back(std::move(material));
+    return id;
+}
+
+void MaterialTable::Clear() {
+    owned.clear();
+    materials.clear();
+    types.clear();
+    ids.clear();
+}
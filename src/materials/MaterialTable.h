@@ -0,0 +1,27 @@
+#pragma once
+#include "materials/Material.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Materials of one scene, referenced by index from primitives and hit records, so recording a hit copies a
+// 32-bit id instead of touching a shared reference count. Shading looks the id up in flat arrays.
+class MaterialTable {
+private:
+    std::vector<std::shared_ptr<Material>> owned;
+    std::vector<const Material*> materials;
+    std::vector<MaterialType> types;
+    std::unordered_map<const Material*, uint32_t> ids;
+public:
+    // Returns the id of material, adding it on first use; kNoMaterial for null
+    uint32_t Add(std::shared_ptr<Material> material);
+    void Clear();
+
+    size_t Size() const { return materials.size(); }
+
+    // Null for kNoMaterial and ids outside the table
+    const Material* Get(uint32_t id) const { return id < materials.size() ? materials[id] : nullptr; }
+    // MaterialType::Other wherever Get returns null
+    MaterialType Type(uint32_t id) const { return id < types.size() ? types[id] : MaterialType::Other; }
+};
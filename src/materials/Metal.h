@@ -4,14 +4,16 @@
 
 class Metal : public Material {
 public:
-    Vec3 albedo;
+    Vec3A albedo;
 
     Metal(const Vec3& albedo);
 
+    virtual MaterialType Type() const override { return MaterialType::Metal; }
+
     virtual bool Scatter(
         const Ray& rayIn,
         const HitRecord& rec,
-        Vec3& attenuation,
+        Vec3A& attenuation,
         Ray& scattered
     ) const override;
 };
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "renderer/BatchRender.h"
+#include "renderer/TileScheduler.h"
+#include "utils/Image.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+bool ParseNumberArgument(const char* name, const char* text, double minimum, double maximum, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(value) || value < minimum || value > maximum) {
+        std::streamsize precision = std::cerr.precision(12);
+        std::cerr << "Invalid value for " << name << ": " << text;
+        if (maximum < std::numeric_limits<double>::max()) {
+            std::cerr << " (expected a number from " << minimum << " to " << maximum << ")" << std::endl;
+        } else {
+            std::cerr << " (expected a finite number of at least " << minimum << ")" << std::endl;
+        }
+        std::cerr.precision(precision);
+        return false;
+    }
+    return true;
+}
+
+bool ParseBatchRenderOptions(int argc, char* argv[], BatchRenderOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* name = argv[i];
+        int* intValue = nullptr;
+        double* doubleValue = nullptr;
+        double minimum = 1.0;
+        if (std::strcmp(name, "--width") == 0) intValue = &options.width;
+        else if (std::strcmp(name, "--height") == 0) intValue = &options.height;
+        else if (std::strcmp(name, "--spp") == 0) intValue = &options.samplesPerPixel;
+        else if (std::strcmp(name, "--spp-per-pass") == 0) intValue = &options.samplesPerPass;
+        else if (std::strcmp(name, "--depth") == 0) intValue = &options.maxDepth;
+        else if (std::strcmp(name, "--tile") == 0) intValue = &options.tileSize;
+        else if (std::strcmp(name, "--threads") == 0) { intValue = &options.threadCount; minimum = 0.0; }
+        else if (std::strcmp(name, "--time") == 0) { doubleValue = &options.timeBudgetSeconds; minimum = 0.0; }
+        else if (std::strcmp(name, "--output") != 0) continue;
+
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << name << std::endl;
+            return false;
+        }
+        const char* text = argv[++i];
+        if (!intValue && !doubleValue) {
+            options.outputPath = text;
+            continue;
+        }
+        // Integer options must fit an int before the cast below
+        double maximum = intValue ? double(std::numeric_limits<int>::max()) : std::numeric_limits<double>::max();
+        double value;
+        if (!ParseNumberArgument(name, text, minimum, maximum, value)) return false;
+        if (intValue) *intValue = static_cast<int>(value);
+        else *doubleValue = value;
+    }
+    return true;
+}
+
+void RenderPass(const Camera& camera, const Scene& scene, const Renderer& renderer, TileScheduler& scheduler,
+    ThreadPool* pool, int width, int height, int samplesPerPixel, int maxDepth, std::vector<Vec3>& colors) {
+    colors.resize(size_t(width) * height);
+    scheduler.Build(width, height, scheduler.TileSize() > 0 ? scheduler.TileSize() : 16);
+    scheduler.Run(pool, [&](const ImageTile& tile) {
+        thread_local std::vector<Vec3> tileColors;
+        tileColors.resize(size_t(tile.width) * tile.height);
+        int step = renderer.packetSize > 0 ? renderer.packetSize : std::max(tile.width, tile.height);
+        for (int y0 = tile.y0; y0 < tile.y0 + tile.height; y0 += step) {
+            int rows = std::min(step, tile.y0 + tile.height - y0);
+            for (int x0 = tile.x0; x0 < tile.x0 + tile.width; x0 += step) {
+                int columns = std::min(step, tile.x0 + tile.width - x0);
+                renderer.RenderTile(camera, scene, x0, y0, columns, rows, width, height, samplesPerPixel, maxDepth,
+                    tileColors.data());
+                for (int y = 0; y < rows; y++) {
+                    for (int x = 0; x < columns; x++) {
+                        colors[size_t(y0 + y) * width + x0 + x] = tileColors[y * columns + x];
+                    }
+                }
+            }
+        }
+    });
+}
+
+BatchRenderStats RenderBatch(const Camera& camera, const Scene& scene, Renderer& renderer, const BatchRenderOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    BatchRenderStats stats;
+    int threadCount = options.threadCount > 0 ? options.threadCount : int(std::max(1u, std::thread::hardware_concurrency()));
+    ThreadPool pool(threadCount);
+    TileScheduler scheduler;
+    scheduler.Build(options.width, options.height, options.tileSize);
+
+    size_t pixelCount = size_t(options.width) * options.height;
+    std::vector<Vec3> sum(pixelCount, Vec3(0, 0, 0));
+    std::vector<Vec3> colors;
+    renderer.ResetPathStats();
+
+    // Every pass renders the same sample count, so the sampler's per-frame sample indices never overlap;
+    // the target is rounded up to whole passes
+    int passSamples = std::min(options.samplesPerPass, options.samplesPerPixel);
+    double imbalanceSum = 0.0;
+    RenderStats countersAtStart = CollectRenderStats();
+    Clock::time_point start = Clock::now();
+    double lastPassSeconds = 0.0;
+    while (stats.samplesPerPixel < options.samplesPerPixel) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (options.timeBudgetSeconds > 0.0 && stats.passes > 0 && elapsed + lastPassSeconds > options.timeBudgetSeconds) break;
+
+        renderer.frameIndex = static_cast<uint32_t>(stats.passes);
+        Clock::time_point passStart = Clock::now();
+        RenderPass(camera, scene, renderer, scheduler, &pool, options.width, options.height, passSamples,
+            options.maxDepth, colors);
+        for (size_t i = 0; i < pixelCount; i++) sum[i] += colors[i] * float(passSamples);
+        lastPassSeconds = std::chrono::duration<double>(Clock::now() - passStart).count();
+        imbalanceSum += scheduler.LastStats().Imbalance();
+        stats.samplesPerPixel += passSamples;
+        stats.passes++;
+    }
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stats.samplesPerSecond = stats.seconds > 0.0 ? double(pixelCount) * stats.samplesPerPixel / stats.seconds : 0.0;
+    stats.averagePathLength = renderer.AveragePathLength();
+    stats.tileImbalance = stats.passes > 0 ? imbalanceSum / stats.passes : 1.0;
+    stats.counters = CollectRenderStats() - countersAtStart;
+
+    Image image(options.width, options.height);
+    for (int j = 0; j < options.height; j++) {
+        for (int i = 0; i < options.width; i++) {
+            image.SetPixel(i, j, sum[size_t(j) * options.width + i] / float(std::max(stats.samplesPerPixel, 1)));
+        }
+    }
+    stats.saved = image.SavePPM(options.outputPath);
+    return stats;
+}
+
+void PrintBatchRenderStats(const BatchRenderOptions& options, const BatchRenderStats& stats) {
+    std::cout << "Rendered " << options.width << "x" << options.height << " at " << stats.samplesPerPixel << "/"
+              << options.samplesPerPixel << " spp in " << stats.passes << " passes, " << stats.seconds << " s" << std::endl;
+    std::cout << "  " << stats.samplesPerSecond / 1e6 << " Msamples/s, avg path length " << stats.averagePathLength
+              << ", avg tile imbalance " << stats.tileImbalance << std::endl;
+#if RT_ENABLE_STATS
+    const RenderStats& counters = stats.counters;
+    std::cout << "  " << counters.TotalRays() << " rays:";
+    for (int depth = 0; depth < kStatDepthBuckets; depth++) {
+        if (counters.raysPerDepth[depth] == 0) continue;
+        std::cout << " depth " << depth << (depth == kStatDepthBuckets - 1 ? "+ " : " ") << counters.raysPerDepth[depth];
+    }
+    std::cout << std::endl;
+    std::cout << "  per ray: " << counters.PerRay(StatCounter::NodeVisits) << " BVH nodes, "
+              << counters.PerRay(StatCounter::AABBTests) << " box tests, "
+              << counters.PerRay(StatCounter::TriangleTests) << " triangle tests, "
+              << counters.PerRay(StatCounter::SphereTests) << " sphere tests, "
+              << counters.PerRay(StatCounter::OtherPrimitiveTests) << " other primitive tests" << std::endl;
+#endif
+    if (stats.saved) {
+        std::cout << "Image saved to " << options.outputPath << std::endl;
+    } else {
+        std::cerr << "Failed to save image to " << options.outputPath << std::endl;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "scene/Scene.h"
+#include "scene/Camera.h"
+#include "renderer/Renderer.h"
+#include "utils/RenderStats.h"
+#include <string>
+#include <vector>
+
+class TileScheduler;
+class ThreadPool;
+
+// Settings of a headless render, filled from the command line by ParseBatchRenderOptions
+struct BatchRenderOptions {
+    int width = 400;
+    int height = 225;
+    int samplesPerPixel = 64;   // Target sample count per pixel, rounded up to whole passes
+    int samplesPerPass = 4;     // Samples per pixel added by each pass over the image
+    int maxDepth = 8;
+    double timeBudgetSeconds = 0.0; // Stop before exceeding this wall-clock time; 0 means no budget
+    int threadCount = 0;        // 0 uses every hardware thread
+    int tileSize = 16;
+    std::string outputPath = "output.ppm";
+};
+
+// Timing of a finished batch render
+struct BatchRenderStats {
+    int passes = 0;
+    int samplesPerPixel = 0;    // Samples per pixel actually rendered
+    double seconds = 0.0;
+    double samplesPerSecond = 0.0;
+    double averagePathLength = 0.0;
+    double tileImbalance = 1.0; // Mean TileStats::Imbalance over the passes
+    RenderStats counters;       // Rays and traversal work of all passes
+    bool saved = false;
+};
+
+// Parses the value of a numeric command-line option. Returns false with a message naming the option on
+// std::cerr unless text is a finite number in [minimum, maximum]; integer options pass INT_MAX as maximum.
+bool ParseNumberArgument(const char* name, const char* text, double minimum, double maximum, double& value);
+
+// Reads --width, --height, --spp, --spp-per-pass, --depth, --time, --threads, --tile and --output.
+// Unknown arguments are ignored so other modes can share the command line; returns false with a
+// message on std::cerr when a value is missing or out of range.
+bool ParseBatchRenderOptions(int argc, char* argv[], BatchRenderOptions& options);
+
+// One pass of samplesPerPixel samples over the whole image, tile by tile on the pool; colors receives
+// each pixel's average, indexed j * width + i
+void RenderPass(const Camera& camera, const Scene& scene, const Renderer& renderer, TileScheduler& scheduler,
+    ThreadPool* pool, int width, int height, int samplesPerPixel, int maxDepth, std::vector<Vec3>& colors);
+
+// Renders passes of samplesPerPass samples per pixel on a thread pool until the target sample count
+// is reached or the next pass would overrun the time budget, then writes the average to outputPath
+BatchRenderStats RenderBatch(const Camera& camera, const Scene& scene, Renderer& renderer, const BatchRenderOptions& options);
+
+void PrintBatchRenderStats(const BatchRenderOptions& options, const BatchRenderStats& stats);
@@ -0,0 +1,50 @@
+#include "renderer/PixelAccumulator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+float Luminance(const Vec3& color) {
+    return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+}
+}
+
+void PixelAccumulator::Resize(size_t pixelCount) {
+    sum.resize(pixelCount);
+    luminanceMean.resize(pixelCount);
+    luminanceM2.resize(pixelCount);
+    frames.resize(pixelCount);
+    retired.resize(pixelCount);
+    Reset();
+}
+
+void PixelAccumulator::Reset() {
+    std::fill(sum.begin(), sum.end(), Vec3(0, 0, 0));
+    std::fill(luminanceMean.begin(), luminanceMean.end(), 0.0);
+    std::fill(luminanceM2.begin(), luminanceM2.end(), 0.0);
+    std::fill(frames.begin(), frames.end(), 0u);
+    std::fill(retired.begin(), retired.end(), uint8_t(0));
+    retiredCount = 0;
+}
+
+Vec3 PixelAccumulator::Add(size_t pixel, const Vec3& color) {
+    double luminance = Luminance(color);
+    sum[pixel] += color;
+    uint32_t n = ++frames[pixel];
+    Vec3 mean = sum[pixel] / float(n);
+
+    double delta = luminance - luminanceMean[pixel];
+    luminanceMean[pixel] += delta / n;
+    luminanceM2[pixel] += delta * (luminance - luminanceMean[pixel]);
+
+    if (errorThreshold > 0.0f && n >= uint32_t(std::max(minFrames, 2))) {
+        // Unbiased variance of the frame estimates, then the standard error of their mean
+        double variance = luminanceM2[pixel] / (n - 1);
+        double standardError = std::sqrt(variance / n);
+        if (standardError <= errorThreshold * std::max(luminanceMean[pixel], 1e-3)) retired[pixel] = 1;
+    }
+    return mean;
+}
+
+void PixelAccumulator::UpdateStats() {
+    retiredCount = size_t(std::count(retired.begin(), retired.end(), uint8_t(1)));
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "core/Vec3.h"
+#include <cstdint>
+#include <vector>
+
+// Running mean of the per-frame estimates of every pixel, with the mean and squared deviations of their
+// luminance kept by Welford's update in double, so converged pixels do not lose their variance to cancellation.
+// Once a pixel has enough frames and the standard error of its mean drops below errorThreshold
+// (relative to its brightness), it is retired: renderers skip it and its mean is shown as is.
+class PixelAccumulator {
+private:
+    std::vector<Vec3> sum;
+    std::vector<double> luminanceMean;
+    std::vector<double> luminanceM2; // Sum of squared deviations from luminanceMean
+    std::vector<uint32_t> frames;
+    std::vector<uint8_t> retired;
+    size_t retiredCount = 0;
+public:
+    // Relative standard error below which a pixel stops receiving samples; 0 disables adaptive sampling
+    float errorThreshold = 0.02f;
+    // Frames a pixel receives before its variance estimate is trusted
+    int minFrames = 16;
+
+    PixelAccumulator() = default;
+    explicit PixelAccumulator(size_t pixelCount) { Resize(pixelCount); }
+
+    void Resize(size_t pixelCount);
+    // Starts over, e.g. when the camera moves
+    void Reset();
+
+    // Adds one frame estimate of the pixel, retires the pixel if it converged, and returns the new mean.
+    // Safe to call concurrently for different pixels.
+    Vec3 Add(size_t pixel, const Vec3& color);
+
+    Vec3 Mean(size_t pixel) const { return frames[pixel] > 0 ? sum[pixel] / float(frames[pixel]) : Vec3(0, 0, 0); }
+    uint32_t Frames(size_t pixel) const { return frames[pixel]; }
+    bool IsRetired(size_t pixel) const { return retired[pixel] != 0; }
+
+    // Nonzero for retired pixels, indexed like the image; suitable for Renderer::RenderTile
+    const uint8_t* RetiredMask() const { return retired.data(); }
+
+    // Counts the retired pixels; call between frames
+    void UpdateStats();
+    // Fraction of pixels still receiving samples as of the last UpdateStats
+    double ActiveFraction() const { return sum.empty() ? 0.0 : 1.0 - double(retiredCount) / sum.size(); }
+};
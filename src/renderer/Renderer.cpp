@@ -1,24 +1,222 @@
 #include "renderer/Renderer.h"
+#include "core/Random.h"
+#include "utils/RenderStats.h"
+#include <chrono>
+#include <vector>
 
-// Trace a single ray through the scene
-Vec3 Renderer::TraceRay(const Ray& ray, const Scene& scene, int depth) const {
-    // Stop recursion after maximum depth
-    if (depth <= 0) return Vec3(1, 1, 1);
+Vec3 Renderer::TraceRay(const Ray& ray, const Scene& scene, int maxDepth) const {
+    uint64_t segments = 0;
+    Vec3 color = TracePath(ray, scene, maxDepth, segments);
+    pathStats.Add(1, segments);
+    return color;
+}
+
+Vec3 Renderer::TracePath(const Ray& ray, const Scene& scene, int maxDepth, uint64_t& segments) const {
+    if (maxDepth <= 0) return Vec3(1, 1, 1);
 
     HitRecord record;
+    segments++;
+    RT_STAT_RAYS(0, 1);
     // Small offset to avoid self-intersection (shadow acne)
-    if (scene.Hit(ray, 0.001f, std::numeric_limits<float>::infinity(), record)) {
+    if (!scene.Hit(ray, 0.001f, std::numeric_limits<float>::infinity(), record)) {
+        return Background(ray);
+    }
+    return ContinuePath(ray, record, scene, maxDepth, segments);
+}
+
+Vec3 Renderer::ContinuePath(Ray ray, HitRecord record, const Scene& scene, int maxDepth, uint64_t& segments) const {
+    Vec3A throughput(1, 1, 1);
+
+    for (int bounce = 1; ; bounce++) {
         Ray scattered;
-        Vec3 attenuation;
-        
-        if (record.material && record.material->Scatter(ray, record, attenuation, scattered)) {
-            return attenuation * TraceRay(scattered, scene, depth - 1);
+        Vec3A attenuation;
+        ThreadSamplerContext().BeginBounce(bounce);
+        const Material* material = scene.GetMaterials().Get(record.materialId);
+        if (!material || !material->Scatter(ray, record, attenuation, scattered)) {
+            return throughput * attenuation;
+        }
+        throughput = throughput * attenuation;
+        if (bounce >= maxDepth) return throughput;
+
+        if (rouletteMinDepth >= 0 && bounce >= rouletteMinDepth) {
+            float survival = std::min(std::max(throughput.x, std::max(throughput.y, throughput.z)), 1.0f);
+            if (RandomFloat() >= survival) return Vec3(0, 0, 0);
+            throughput /= survival;
+        }
+
+        ray = scattered;
+        segments++;
+        RT_STAT_RAYS(bounce, 1);
+        if (!scene.Hit(ray, 0.001f, std::numeric_limits<float>::infinity(), record)) {
+            return throughput * Background(ray);
         }
-        return attenuation;
     }
-    
-    // Background gradient (sky)
-    Vec3 unitDirection = ray.direction.Normalize();
+}
+
+// Background gradient (sky)
+Vec3 Renderer::Background(const Ray& ray) {
+    Vec3A unitDirection = ray.direction.Normalize();
     float t = 0.5f * (unitDirection.y + 1.0f);
     return Vec3(1.0f, 1.0f, 1.0f) * (1.0f - t) + Vec3(0.5f, 0.7f, 1.0f) * t;
 }
+
+void Renderer::TracePacket(RayPacket& packet, const Scene& scene, int depth, Vec3* colors, const RandomStream* streams,
+    const SamplerContext* samples) const {
+    if (depth <= 0) {
+        for (int i = 0; i < packet.size; i++) colors[i] = Vec3(1, 1, 1);
+        return;
+    }
+
+    scene.HitPacket(packet, 0.001f);
+    RT_STAT_RAYS(0, packet.size);
+    uint64_t segments = packet.size;
+    for (int i = 0; i < packet.size; i++) {
+        if (!packet.hit[i]) {
+            colors[i] = Background(packet.rays[i]);
+            continue;
+        }
+        if (streams) ThreadRandomStream() = streams[i];
+        if (samples) ThreadSamplerContext() = samples[i];
+        colors[i] = ContinuePath(packet.rays[i], packet.records[i], scene, depth, segments);
+    }
+    pathStats.Add(packet.size, segments);
+}
+
+void Renderer::RenderTile(const Camera& camera, const Scene& scene, int x0, int y0, int tileWidth, int tileHeight,
+    int imageWidth, int imageHeight, int samplesPerPixel, int maxDepth, Vec3* colors, const uint8_t* retired) const {
+    int pixelCount = tileWidth * tileHeight;
+    auto isRetired = [&](int x, int y) {
+        return retired && retired[size_t(y0 + y) * imageWidth + (x0 + x)];
+    };
+
+    // Camera jitter for every sample of the tile, filled pixel by pixel; the values depend
+    // only on pixel, sample and frame, never on how the image was split into tiles or threads
+    thread_local std::vector<float> jitter;
+    if (!sampler) {
+        jitter.resize(size_t(pixelCount) * samplesPerPixel * 2);
+        for (int y = 0; y < tileHeight; y++) {
+            for (int x = 0; x < tileWidth; x++) {
+                uint32_t pixel = uint32_t(y0 + y) * imageWidth + (x0 + x);
+                RandomStream jitterStream = CameraJitterStream(pixel, frameIndex);
+                jitterStream.Fill(&jitter[(size_t(y) * tileWidth + x) * samplesPerPixel * 2], size_t(samplesPerPixel) * 2);
+            }
+        }
+    }
+    // Sampler state of sample s of a pixel, positioned on the jitter dimensions
+    auto pathSamples = [&](int x, int y, int s) {
+        SamplerContext context;
+        context.sampler = sampler.get();
+        context.x = uint32_t(x0 + x);
+        context.y = uint32_t(y0 + y);
+        context.sample = SamplerSampleIndex(frameIndex, samplesPerPixel, s);
+        return context;
+    };
+    auto sampleUV = [&](int x, int y, int s, float& u, float& v) {
+        float offset[2];
+        if (sampler) {
+            SamplerContext context = pathSamples(x, y, s);
+            context.Next2D(offset[0], offset[1]);
+        } else {
+            const float* values = &jitter[((size_t(y) * tileWidth + x) * samplesPerPixel + s) * 2];
+            offset[0] = values[0];
+            offset[1] = values[1];
+        }
+        u = (x0 + x + offset[0]) / (imageWidth - 1);
+        v = (y0 + y + offset[1]) / (imageHeight - 1);
+    };
+
+    RandomStream& rng = ThreadRandomStream();
+    SamplerContext& samples = ThreadSamplerContext();
+
+    if (packetSize <= 0 || pixelCount > RayPacket::kMaxSize) {
+        uint64_t segments = 0;
+        uint64_t paths = 0;
+        for (int y = 0; y < tileHeight; y++) {
+            for (int x = 0; x < tileWidth; x++) {
+                if (isRetired(x, y)) continue;
+                paths += samplesPerPixel;
+                uint32_t pixel = uint32_t(y0 + y) * imageWidth + (x0 + x);
+                Vec3 pixelColor(0, 0, 0);
+                for (int s = 0; s < samplesPerPixel; ++s) {
+                    float u, v;
+                    sampleUV(x, y, s, u, v);
+                    rng.Seed(pixel, frameIndex, s);
+                    samples = pathSamples(x, y, s);
+                    pixelColor += TracePath(camera.GetRay(u, v), scene, maxDepth, segments);
+                }
+                colors[y * tileWidth + x] = pixelColor / float(samplesPerPixel);
+            }
+        }
+        pathStats.Add(paths, segments);
+        return;
+    }
+
+    // One packet per sample index, so every packet holds one jittered ray per pixel of the tile
+    RayPacket packet;
+    RandomStream streams[RayPacket::kMaxSize];
+    SamplerContext pathContexts[RayPacket::kMaxSize];
+    Vec3 sampleColors[RayPacket::kMaxSize];
+    int packetPixel[RayPacket::kMaxSize]; // Tile pixel of every packet ray
+    for (int i = 0; i < pixelCount; i++) {
+        if (!isRetired(i % tileWidth, i / tileWidth)) colors[i] = Vec3(0, 0, 0);
+    }
+
+    for (int s = 0; s < samplesPerPixel; ++s) {
+        packet.size = 0;
+        for (int y = 0; y < tileHeight; y++) {
+            for (int x = 0; x < tileWidth; x++) {
+                if (isRetired(x, y)) continue;
+                packetPixel[packet.size] = y * tileWidth + x;
+                float u, v;
+                sampleUV(x, y, s, u, v);
+                streams[packet.size].Seed(uint32_t(y0 + y) * imageWidth + (x0 + x), frameIndex, s);
+                pathContexts[packet.size] = pathSamples(x, y, s);
+                packet.Add(camera.GetRay(u, v), std::numeric_limits<float>::infinity());
+            }
+        }
+        if (packet.size == 0) return;
+        packet.Finalize();
+        TracePacket(packet, scene, maxDepth, sampleColors, streams, pathContexts);
+        for (int i = 0; i < packet.size; i++) colors[packetPixel[i]] += sampleColors[i];
+    }
+
+    for (int i = 0; i < packet.size; i++) colors[packetPixel[i]] /= float(samplesPerPixel);
+}
+
+PrimaryRayThroughput Renderer::MeasurePrimaryThroughput(const Camera& camera, const Scene& scene,
+    int imageWidth, int imageHeight, int packetSize) const {
+    PrimaryRayThroughput throughput{ 0.0, 0.0 };
+    packetSize = std::min(std::max(packetSize, 1), 8);
+    double rayCount = double(imageWidth) * imageHeight;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int j = 0; j < imageHeight; j++) {
+        for (int i = 0; i < imageWidth; i++) {
+            HitRecord record;
+            Ray ray = camera.GetRay((i + 0.5f) / (imageWidth - 1), (j + 0.5f) / (imageHeight - 1));
+            scene.Hit(ray, 0.001f, std::numeric_limits<float>::infinity(), record);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    throughput.singleRaysPerSecond = seconds > 0.0 ? rayCount / seconds : 0.0;
+
+    RayPacket packet;
+    start = std::chrono::steady_clock::now();
+    for (int y0 = 0; y0 < imageHeight; y0 += packetSize) {
+        for (int x0 = 0; x0 < imageWidth; x0 += packetSize) {
+            packet.size = 0;
+            for (int j = y0; j < std::min(y0 + packetSize, imageHeight); j++) {
+                for (int i = x0; i < std::min(x0 + packetSize, imageWidth); i++) {
+                    Ray ray = camera.GetRay((i + 0.5f) / (imageWidth - 1), (j + 0.5f) / (imageHeight - 1));
+                    packet.Add(ray, std::numeric_limits<float>::infinity());
+                }
+            }
+            packet.Finalize();
+            scene.HitPacket(packet, 0.001f);
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    throughput.packetRaysPerSecond = seconds > 0.0 ? rayCount / seconds : 0.0;
+
+    return throughput;
+}
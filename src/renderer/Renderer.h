@@ -1,10 +1,99 @@
 #pragma once
 #include "scene/Scene.h"
+#include "scene/Camera.h"
 #include "core/Ray.h"
+#include "geometry/RayPacket.h"
 #include "materials/Material.h"
+#include "core/Random.h"
+#include "core/Sampler.h"
 #include <limits>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+// Primary rays per second measured by Renderer::MeasurePrimaryThroughput
+struct PrimaryRayThroughput {
+    double singleRaysPerSecond;
+    double packetRaysPerSecond;
+};
+
+// Rays traced per path, summed over all render threads. Copies start from zero.
+struct PathStats {
+    std::atomic<uint64_t> paths{ 0 };
+    std::atomic<uint64_t> segments{ 0 };
+
+    PathStats() = default;
+    PathStats(const PathStats&) {}
+    PathStats& operator=(const PathStats&) { return *this; }
+
+    void Add(uint64_t pathCount, uint64_t segmentCount) {
+        paths.fetch_add(pathCount, std::memory_order_relaxed);
+        segments.fetch_add(segmentCount, std::memory_order_relaxed);
+    }
+};
+
+// Stream whose values sample * 2 and sample * 2 + 1 jitter that camera sample of the pixel. Keying by pixel
+// keeps the counter below 2 * samplesPerPixel, so streams of distant pixels never overlap on large images
+inline RandomStream CameraJitterStream(uint32_t pixel, uint32_t frame) {
+    return RandomStream(pixel, frame, 0xffffffffu);
+}
+
+// Sample index a Sampler sees for sample s of a frame, so progressive frames continue one sequence per pixel
+inline uint32_t SamplerSampleIndex(uint32_t frame, int samplesPerPixel, int sample) {
+    return frame * uint32_t(samplesPerPixel) + uint32_t(sample);
+}
 
 class Renderer {
+private:
+    mutable PathStats pathStats;
+
+    // Follows a path bounce by bounce from its first hit, adding every further ray traced to segments
+    Vec3 ContinuePath(Ray ray, HitRecord record, const Scene& scene, int maxDepth, uint64_t& segments) const;
 public:
-    Vec3 TraceRay(const Ray& ray, const Scene& scene, int depth) const;
-};
\ No newline at end of file
+    // Sky gradient seen by rays that leave the scene
+    static Vec3 Background(const Ray& ray);
+
+    // Side of the square pixel tiles traced as one packet of primary rays (4 or 8); 0 traces every ray on its own
+    int packetSize = 0;
+
+    // Bounce count after which Russian roulette may end a path; negative disables roulette
+    int rouletteMinDepth = 3;
+
+    // Iterative path tracer: accumulates throughput along the path and, past rouletteMinDepth, ends it
+    // with probability 1 - max(throughput), reweighting survivors. Paths that reach maxDepth return white.
+    Vec3 TraceRay(const Ray& ray, const Scene& scene, int maxDepth) const;
+    // TraceRay without touching the shared stats; the rays traced are added to segments
+    Vec3 TracePath(const Ray& ray, const Scene& scene, int maxDepth, uint64_t& segments) const;
+
+    // Average rays per path since the last reset, 0 if no path was traced
+    double AveragePathLength() const {
+        uint64_t paths = pathStats.paths.load(std::memory_order_relaxed);
+        return paths > 0 ? double(pathStats.segments.load(std::memory_order_relaxed)) / paths : 0.0;
+    }
+    void ResetPathStats() const {
+        pathStats.paths = 0;
+        pathStats.segments = 0;
+    }
+
+    // Seeds the per-path random streams, so renders are identical for any thread count; advance it every frame
+    uint32_t frameIndex = 0;
+
+    // Camera jitter and BSDF samples; null draws them from the per-path random streams
+    std::shared_ptr<Sampler> sampler;
+
+    // Colors for a finalized packet of primary rays; the bounces after the first hit are traced as single paths,
+    // each drawing from streams[i] and samples[i] when given
+    void TracePacket(RayPacket& packet, const Scene& scene, int depth, Vec3* colors,
+        const RandomStream* streams = nullptr, const SamplerContext* samples = nullptr) const;
+
+    // Average of samplesPerPixel jittered samples for each pixel in [x0, x0 + tileWidth) x [y0, y0 + tileHeight),
+    // written row by row to colors. Uses packets when packetSize is set. Pixels set in retired (indexed
+    // y * imageWidth + x, e.g. PixelAccumulator::RetiredMask) are not traced and their colors are left as is.
+    void RenderTile(const Camera& camera, const Scene& scene, int x0, int y0, int tileWidth, int tileHeight,
+        int imageWidth, int imageHeight, int samplesPerPixel, int maxDepth, Vec3* colors,
+        const uint8_t* retired = nullptr) const;
+
+    // Times one closest-hit query per pixel center, once ray by ray and once in packets of packetSize x packetSize
+    PrimaryRayThroughput MeasurePrimaryThroughput(const Camera& camera, const Scene& scene,
+        int imageWidth, int imageHeight, int packetSize) const;
+};
@@ -0,0 +1,71 @@
+#include "renderer/SamplerComparison.h"
+#include "renderer/Renderer.h"
+#include "utils/ThreadPool.h"
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+std::vector<Vec3> RenderImage(const Renderer& renderer, const Camera& camera, const Scene& scene, int imageWidth,
+    int imageHeight, int samplesPerPixel, int maxDepth, ThreadPool* pool) {
+    std::vector<Vec3> image(size_t(imageWidth) * imageHeight);
+    auto renderRow = [&](int row) {
+        renderer.RenderTile(camera, scene, 0, row, imageWidth, 1, imageWidth, imageHeight, samplesPerPixel, maxDepth,
+            &image[size_t(row) * imageWidth]);
+    };
+    if (pool) {
+        pool->ParallelFor(imageHeight, renderRow);
+    } else {
+        for (int row = 0; row < imageHeight; row++) renderRow(row);
+    }
+    return image;
+}
+
+double RootMeanSquareError(const std::vector<Vec3>& image, const std::vector<Vec3>& reference) {
+    double sum = 0.0;
+    for (size_t i = 0; i < image.size(); i++) {
+        Vec3 difference = image[i] - reference[i];
+        sum += difference.x * difference.x + difference.y * difference.y + difference.z * difference.z;
+    }
+    return image.empty() ? 0.0 : std::sqrt(sum / (image.size() * 3.0));
+}
+}
+
+std::vector<SamplerError> CompareSamplers(const Camera& camera, const Scene& scene, int imageWidth, int imageHeight,
+    int maxDepth, int maxSamplesPerPixel, int referenceSamplesPerPixel, ThreadPool* pool) {
+    const SamplerType types[] = { SamplerType::Independent, SamplerType::Stratified, SamplerType::Sobol, SamplerType::BlueNoise };
+
+    // Roulette would add the same noise to every sampler, so paths run to maxDepth
+    Renderer renderer;
+    renderer.rouletteMinDepth = -1;
+    renderer.sampler = CreateSampler(SamplerType::Sobol, referenceSamplesPerPixel);
+    // Frame 1 of the reference covers Sobol indices past every test image's frame 0, so they share no samples
+    renderer.frameIndex = 1;
+    std::cout << "Rendering " << referenceSamplesPerPixel << " spp reference at "
+              << imageWidth << "x" << imageHeight << "..." << std::endl;
+    std::vector<Vec3> reference = RenderImage(renderer, camera, scene, imageWidth, imageHeight,
+        referenceSamplesPerPixel, maxDepth, pool);
+
+    std::vector<SamplerError> errors;
+    renderer.frameIndex = 0;
+    for (SamplerType type : types) {
+        for (int spp = 1; spp <= maxSamplesPerPixel; spp *= 2) {
+            renderer.sampler = CreateSampler(type, spp);
+            std::vector<Vec3> image = RenderImage(renderer, camera, scene, imageWidth, imageHeight, spp, maxDepth, pool);
+            errors.push_back({ type, spp, RootMeanSquareError(image, reference) });
+        }
+    }
+
+    const size_t typeCount = sizeof(types) / sizeof(types[0]);
+    const size_t rows = errors.size() / typeCount;
+    std::cout << std::left << std::setw(6) << "spp" << std::right;
+    for (SamplerType type : types) std::cout << std::setw(13) << SamplerTypeName(type);
+    std::cout << std::endl << std::fixed << std::setprecision(6);
+    for (size_t row = 0; row < rows; row++) {
+        std::cout << std::left << std::setw(6) << errors[row].samplesPerPixel << std::right;
+        for (size_t column = 0; column < typeCount; column++) std::cout << std::setw(13) << errors[column * rows + row].rmse;
+        std::cout << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    return errors;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "scene/Scene.h"
+#include "scene/Camera.h"
+#include "core/Sampler.h"
+#include <vector>
+
+class ThreadPool;
+
+// RMSE of one sampler at one sample count, measured against the reference image
+struct SamplerError {
+    SamplerType type;
+    int samplesPerPixel;
+    double rmse;
+};
+
+// Renders the scene with every sampler type at 1, 2, 4 ... maxSamplesPerPixel samples per pixel and
+// compares each image to a referenceSamplesPerPixel render, printing an RMSE-vs-spp table to std::cout
+std::vector<SamplerError> CompareSamplers(const Camera& camera, const Scene& scene, int imageWidth, int imageHeight,
+    int maxDepth, int maxSamplesPerPixel = 64, int referenceSamplesPerPixel = 1024, ThreadPool* pool = nullptr);
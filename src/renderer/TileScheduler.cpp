@@ -0,0 +1,77 @@
+#include "renderer/TileScheduler.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace {
+uint32_t MortonCode(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t v) {
+        v &= 0xffffu;
+        v = (v | (v << 8)) & 0x00ff00ffu;
+        v = (v | (v << 4)) & 0x0f0f0f0fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+}
+
+void TileScheduler::Build(int width, int height, int size) {
+    size = std::max(size, 1);
+    if (size == tileSize && width == imageWidth && height == imageHeight) return;
+    tileSize = size;
+    imageWidth = width;
+    imageHeight = height;
+
+    int tilesX = (width + size - 1) / size;
+    int tilesY = (height + size - 1) / size;
+    std::vector<std::pair<uint32_t, ImageTile>> ordered;
+    ordered.reserve(size_t(tilesX) * tilesY);
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            ImageTile tile{ tx * size, ty * size, std::min(size, width - tx * size), std::min(size, height - ty * size) };
+            ordered.emplace_back(MortonCode(uint32_t(tx), uint32_t(ty)), tile);
+        }
+    }
+    std::sort(ordered.begin(), ordered.end(),
+        [](const std::pair<uint32_t, ImageTile>& a, const std::pair<uint32_t, ImageTile>& b) { return a.first < b.first; });
+
+    tiles.clear();
+    tiles.reserve(ordered.size());
+    for (const auto& entry : ordered) tiles.push_back(entry.second);
+}
+
+void TileScheduler::Run(ThreadPool* pool, const std::function<void(const ImageTile&)>& renderTile) {
+    using Clock = std::chrono::steady_clock;
+    int workerCount = pool ? std::max(pool->Size(), 1) : 1;
+    workerSeconds.assign(workerCount, 0.0);
+    nextTile.store(0, std::memory_order_relaxed);
+
+    auto worker = [&](int index) {
+        Clock::time_point start = Clock::now();
+        for (size_t i = nextTile.fetch_add(1, std::memory_order_relaxed); i < tiles.size();
+             i = nextTile.fetch_add(1, std::memory_order_relaxed)) {
+            renderTile(tiles[i]);
+        }
+        workerSeconds[index] = std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    Clock::time_point frameStart = Clock::now();
+    if (pool) {
+        pool->ParallelFor(workerCount, worker);
+    } else {
+        worker(0);
+    }
+
+    stats.tileCount = static_cast<int>(tiles.size());
+    stats.workerCount = workerCount;
+    stats.frameSeconds = std::chrono::duration<double>(Clock::now() - frameStart).count();
+    stats.maxWorkerSeconds = 0.0;
+    stats.meanWorkerSeconds = 0.0;
+    for (double seconds : workerSeconds) {
+        stats.maxWorkerSeconds = std::max(stats.maxWorkerSeconds, seconds);
+        stats.meanWorkerSeconds += seconds / workerCount;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+// Rectangle of pixels [x0, x0 + width) x [y0, y0 + height)
+struct ImageTile {
+    int x0;
+    int y0;
+    int width;
+    int height;
+};
+
+// How evenly the tiles of one TileScheduler::Run were spread over the workers
+struct TileStats {
+    int tileCount = 0;
+    int workerCount = 0;
+    double frameSeconds = 0.0;
+    double maxWorkerSeconds = 0.0;  // Time the busiest worker spent rendering tiles
+    double meanWorkerSeconds = 0.0;
+
+    // Busiest worker time over the mean worker time; 1 is a perfect balance
+    double Imbalance() const { return meanWorkerSeconds > 0.0 ? maxWorkerSeconds / meanWorkerSeconds : 1.0; }
+};
+
+// Splits the image into square tiles ordered along a Morton curve, so consecutive tiles are neighbors
+// on screen. Every worker pulls the next tile from a shared atomic counter until none are left, so
+// expensive regions are spread over all threads instead of stalling the one that owns them.
+class TileScheduler {
+private:
+    std::vector<ImageTile> tiles;
+    std::atomic<size_t> nextTile{ 0 };
+    std::vector<double> workerSeconds;
+    int tileSize = 0;
+    int imageWidth = 0;
+    int imageHeight = 0;
+    TileStats stats;
+public:
+    // Rebuilds the tile list when the image or tile size changed
+    void Build(int imageWidth, int imageHeight, int tileSize);
+
+    // Calls renderTile once for every tile, spread over the pool's threads (inline when pool is null)
+    void Run(ThreadPool* pool, const std::function<void(const ImageTile&)>& renderTile);
+
+    int TileSize() const { return tileSize; }
+    const std::vector<ImageTile>& Tiles() const { return tiles; }
+    const TileStats& LastStats() const { return stats; }
+};
@@ -0,0 +1,284 @@
+#include "renderer/WavefrontIntegrator.h"
+#include "renderer/Renderer.h"
+#include "materials/Lambertian.h"
+#include "materials/Metal.h"
+#include "materials/Dielectric.h"
+#include "materials/Emissive.h"
+#include "utils/ThreadPool.h"
+#include "utils/RenderStats.h"
+#include "core/Random.h"
+#include <limits>
+
+namespace {
+constexpr size_t kWavefrontChunkSize = 4096;
+// Upper bound on paths per wave; larger frames are rendered in several waves
+constexpr size_t kMaxPathsPerWave = size_t(1) << 18;
+// Hit keys: 0 for a miss, MaterialType + 1 for a shaded hit, and a last key for hits without material
+constexpr uint8_t kNoMaterialKey = static_cast<uint8_t>(MaterialType::Other) + 2;
+constexpr int kHitKeyCount = kNoMaterialKey + 1;
+}
+
+void PathQueue::Resize(size_t count) {
+    origin.resize(count);
+    direction.resize(count);
+    throughput.resize(count);
+    pathIndex.resize(count);
+    depth.resize(count);
+    hit.resize(count);
+    hitKey.resize(count);
+    alive.resize(count);
+    rng.resize(count);
+    size = count;
+}
+
+template <typename Function>
+void WavefrontIntegrator::ParallelChunks(size_t count, Function&& function) {
+    size_t chunkCount = (count + kWavefrontChunkSize - 1) / kWavefrontChunkSize;
+    auto runChunk = [&](size_t chunk) {
+        size_t begin = chunk * kWavefrontChunkSize;
+        function(chunk, begin, std::min(begin + kWavefrontChunkSize, count));
+    };
+
+    if (!threadPool || chunkCount <= 1) {
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) runChunk(chunk);
+        return;
+    }
+    threadPool->ParallelFor(static_cast<int>(chunkCount), [&](int chunk) { runChunk(static_cast<size_t>(chunk)); });
+}
+
+void WavefrontIntegrator::Generate(const Camera& camera, size_t firstPixel, size_t pixelCount, int imageWidth,
+    int imageHeight, int samplesPerPixel) {
+    size_t pathCount = pixelCount * samplesPerPixel;
+    paths.Resize(pathCount);
+    radiance.assign(pathCount, Vec3(0, 0, 0));
+    waveFirstPixel = firstPixel;
+    waveImageWidth = imageWidth;
+    waveSamplesPerPixel = samplesPerPixel;
+
+    ParallelChunks(pathCount, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            size_t pixel = firstPixel + i / samplesPerPixel;
+            int sample = static_cast<int>(i % samplesPerPixel);
+            int x = static_cast<int>(pixel % imageWidth);
+            int y = static_cast<int>(pixel / imageWidth);
+            float offsetU, offsetV;
+            if (sampler) {
+                uint32_t sampleIndex = SamplerSampleIndex(frameIndex, samplesPerPixel, sample);
+                offsetU = sampler->Get(uint32_t(x), uint32_t(y), sampleIndex, 0);
+                offsetV = sampler->Get(uint32_t(x), uint32_t(y), sampleIndex, 1);
+            } else {
+                RandomStream jitterStream = CameraJitterStream(static_cast<uint32_t>(pixel), frameIndex);
+                uint32_t jitterIndex = static_cast<uint32_t>(sample) * 2;
+                offsetU = RandomStream::ToFloat(jitterStream.Generate(jitterIndex));
+                offsetV = RandomStream::ToFloat(jitterStream.Generate(jitterIndex + 1));
+            }
+            Ray ray = camera.GetRay((x + offsetU) / (imageWidth - 1), (y + offsetV) / (imageHeight - 1));
+            paths.rng[i].Seed(static_cast<uint32_t>(pixel), frameIndex, static_cast<uint32_t>(sample));
+
+            paths.origin[i] = ray.origin;
+            paths.direction[i] = ray.direction;
+            paths.throughput[i] = Vec3(1, 1, 1);
+            paths.pathIndex[i] = static_cast<uint32_t>(i);
+            paths.depth[i] = maxDepth;
+        }
+    });
+}
+
+void WavefrontIntegrator::Extend(const Scene& scene) {
+    const MaterialTable& materials = scene.GetMaterials();
+    ParallelChunks(paths.size, [&](size_t, size_t begin, size_t end) {
+        Ray ray;
+        for (size_t i = begin; i < end; i++) {
+            // Directions are stored normalized, so the ray is assembled without renormalizing
+            ray.origin = paths.origin[i];
+            ray.direction = paths.direction[i];
+            HitRecord& record = paths.hit[i];
+            if (!scene.Hit(ray, 0.001f, std::numeric_limits<float>::infinity(), record)) {
+                paths.hitKey[i] = 0;
+            } else if (materials.Get(record.materialId)) {
+                paths.hitKey[i] = static_cast<uint8_t>(static_cast<int>(materials.Type(record.materialId)) + 1);
+            } else {
+                paths.hitKey[i] = kNoMaterialKey;
+            }
+        }
+    });
+}
+
+void WavefrontIntegrator::SortByMaterial() {
+    // Counting sort: per-chunk histograms, an exclusive scan ordered by key then chunk, and a stable scatter
+    size_t chunkCount = (paths.size + kWavefrontChunkSize - 1) / kWavefrontChunkSize;
+    chunkCounts.assign(chunkCount * kHitKeyCount, 0);
+    order.resize(paths.size);
+
+    ParallelChunks(paths.size, [&](size_t chunk, size_t begin, size_t end) {
+        size_t* counts = &chunkCounts[chunk * kHitKeyCount];
+        for (size_t i = begin; i < end; i++) counts[paths.hitKey[i]]++;
+    });
+
+    size_t offset = 0;
+    for (int key = 0; key < kHitKeyCount; key++) {
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            size_t& count = chunkCounts[chunk * kHitKeyCount + key];
+            size_t start = offset;
+            offset += count;
+            count = start;
+        }
+    }
+
+    ParallelChunks(paths.size, [&](size_t chunk, size_t begin, size_t end) {
+        size_t* next = &chunkCounts[chunk * kHitKeyCount];
+        for (size_t i = begin; i < end; i++) order[next[paths.hitKey[i]]++] = static_cast<uint32_t>(i);
+    });
+}
+
+void WavefrontIntegrator::Shade(const Scene& scene) {
+    const MaterialTable& materials = scene.GetMaterials();
+    ParallelChunks(paths.size, [&](size_t, size_t begin, size_t end) {
+        Ray rayIn;
+        for (size_t k = begin; k < end; k++) {
+            uint32_t i = order[k];
+            rayIn.origin = paths.origin[i];
+            rayIn.direction = paths.direction[i];
+            Vec3& pathRadiance = radiance[paths.pathIndex[i]];
+            paths.alive[i] = 0;
+
+            uint8_t key = paths.hitKey[i];
+            if (key == 0) {
+                pathRadiance += paths.throughput[i] * Renderer::Background(rayIn);
+                continue;
+            }
+            // A hit without material ends the path with black, as in TraceRay
+            if (key == kNoMaterialKey) continue;
+
+            RandomStream& rng = ThreadRandomStream();
+            rng = paths.rng[i];
+            SamplerContext& samples = ThreadSamplerContext();
+            size_t pixel = waveFirstPixel + paths.pathIndex[i] / waveSamplesPerPixel;
+            samples.sampler = sampler.get();
+            samples.x = static_cast<uint32_t>(pixel % waveImageWidth);
+            samples.y = static_cast<uint32_t>(pixel / waveImageWidth);
+            samples.sample = SamplerSampleIndex(frameIndex, waveSamplesPerPixel, paths.pathIndex[i] % waveSamplesPerPixel);
+            samples.BeginBounce(maxDepth - paths.depth[i] + 1);
+
+            // Hits are grouped by type, so each run calls one non-virtual Scatter
+            const HitRecord& record = paths.hit[i];
+            const Material* material = materials.Get(record.materialId);
+            Vec3A attenuation;
+            Ray scattered;
+            bool didScatter;
+            switch (static_cast<MaterialType>(key - 1)) {
+                case MaterialType::Lambertian:
+                    didScatter = static_cast<const Lambertian*>(material)->Lambertian::Scatter(rayIn, record, attenuation, scattered);
+                    break;
+                case MaterialType::Metal:
+                    didScatter = static_cast<const Metal*>(material)->Metal::Scatter(rayIn, record, attenuation, scattered);
+                    break;
+                case MaterialType::Dielectric:
+                    didScatter = static_cast<const Dielectric*>(material)->Dielectric::Scatter(rayIn, record, attenuation, scattered);
+                    break;
+                case MaterialType::Emissive:
+                    didScatter = static_cast<const Emissive*>(material)->Emissive::Scatter(rayIn, record, attenuation, scattered);
+                    break;
+                default:
+                    didScatter = material->Scatter(rayIn, record, attenuation, scattered);
+                    break;
+            }
+
+            if (!didScatter) {
+                pathRadiance += paths.throughput[i] * attenuation;
+                continue;
+            }
+
+            Vec3 throughput = paths.throughput[i] * attenuation;
+            if (--paths.depth[i] <= 0) {
+                // Out of bounces: TraceRay returns white at depth 0
+                pathRadiance += throughput;
+                continue;
+            }
+            int bounce = maxDepth - paths.depth[i];
+            if (rouletteMinDepth >= 0 && bounce >= rouletteMinDepth) {
+                float survival = std::min(std::max(throughput.x, std::max(throughput.y, throughput.z)), 1.0f);
+                if (RandomFloat() >= survival) continue;
+                throughput /= survival;
+            }
+            paths.throughput[i] = throughput;
+            paths.rng[i] = rng;
+            paths.origin[i] = scattered.origin;
+            paths.direction[i] = scattered.direction;
+            paths.alive[i] = 1;
+        }
+    });
+}
+
+void WavefrontIntegrator::Compact() {
+    size_t chunkCount = (paths.size + kWavefrontChunkSize - 1) / kWavefrontChunkSize;
+    chunkCounts.assign(chunkCount, 0);
+
+    ParallelChunks(paths.size, [&](size_t chunk, size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) count += paths.alive[i];
+        chunkCounts[chunk] = count;
+    });
+
+    size_t survivors = 0;
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        size_t count = chunkCounts[chunk];
+        chunkCounts[chunk] = survivors;
+        survivors += count;
+    }
+
+    compacted.Resize(survivors);
+    ParallelChunks(paths.size, [&](size_t chunk, size_t begin, size_t end) {
+        size_t next = chunkCounts[chunk];
+        for (size_t i = begin; i < end; i++) {
+            if (!paths.alive[i]) continue;
+            compacted.origin[next] = paths.origin[i];
+            compacted.direction[next] = paths.direction[i];
+            compacted.throughput[next] = paths.throughput[i];
+            compacted.pathIndex[next] = paths.pathIndex[i];
+            compacted.depth[next] = paths.depth[i];
+            compacted.rng[next] = paths.rng[i];
+            next++;
+        }
+    });
+    std::swap(paths, compacted);
+}
+
+void WavefrontIntegrator::Render(const Camera& camera, const Scene& scene, int imageWidth, int imageHeight,
+    int samplesPerPixel, int depth, std::vector<Vec3>& colors, ThreadPool* pool) {
+    threadPool = pool;
+    maxDepth = depth;
+    pathsTraced = 0;
+    segmentsTraced = 0;
+    size_t pixelCount = size_t(imageWidth) * imageHeight;
+    colors.assign(pixelCount, Vec3(0, 0, 0));
+    if (samplesPerPixel <= 0) return;
+    if (maxDepth <= 0) {
+        colors.assign(pixelCount, Vec3(1, 1, 1));
+        return;
+    }
+
+    size_t pixelsPerWave = std::max<size_t>(1, kMaxPathsPerWave / samplesPerPixel);
+    for (size_t firstPixel = 0; firstPixel < pixelCount; firstPixel += pixelsPerWave) {
+        size_t wavePixels = std::min(pixelsPerWave, pixelCount - firstPixel);
+        Generate(camera, firstPixel, wavePixels, imageWidth, imageHeight, samplesPerPixel);
+        pathsTraced += paths.size;
+
+        for (int bounce = 0; paths.size > 0; bounce++) {
+            segmentsTraced += paths.size;
+            RT_STAT_RAYS(bounce, paths.size);
+            Extend(scene);
+            SortByMaterial();
+            Shade(scene);
+            Compact();
+        }
+
+        ParallelChunks(wavePixels, [&](size_t, size_t begin, size_t end) {
+            for (size_t p = begin; p < end; p++) {
+                Vec3 sum(0, 0, 0);
+                for (int s = 0; s < samplesPerPixel; s++) sum += radiance[p * samplesPerPixel + s];
+                colors[firstPixel + p] = sum / float(samplesPerPixel);
+            }
+        });
+    }
+}
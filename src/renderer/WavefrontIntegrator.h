@@ -0,0 +1,71 @@
+#pragma once
+#include "scene/Scene.h"
+#include "scene/Camera.h"
+#include "core/Random.h"
+#include "core/Sampler.h"
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+class ThreadPool;
+
+// Path state for every path in flight, one array per field
+struct PathQueue {
+    std::vector<Vec3> origin;
+    std::vector<Vec3> direction;
+    std::vector<Vec3> throughput;
+    std::vector<uint32_t> pathIndex; // Slot in the radiance buffer of the current wave
+    std::vector<int> depth;          // Bounces left before the path is cut off
+    std::vector<HitRecord> hit;
+    std::vector<uint8_t> hitKey;     // 0 on a miss, otherwise MaterialType + 1
+    std::vector<uint8_t> alive;
+    std::vector<RandomStream> rng;   // Seeded from (pixel, frame, sample) and carried along the path
+    size_t size = 0;
+
+    void Resize(size_t count);
+};
+
+// Alternative to the recursive Renderer::TraceRay that advances all paths of a wave one bounce at a time:
+// generate camera paths, extend (intersect), sort hits by material type, shade, then compact the survivors.
+// Every stage is split into chunks that run on the thread pool. Produces the same estimate as TraceRay.
+class WavefrontIntegrator {
+private:
+    PathQueue paths;
+    PathQueue compacted;
+    std::vector<uint32_t> order;   // Path indices grouped by hit key
+    std::vector<Vec3> radiance;    // One entry per path of the wave
+    std::vector<size_t> chunkCounts;
+    ThreadPool* threadPool = nullptr;
+    int maxDepth = 0;
+    // Layout of the current wave, to recover a path's pixel and sample from its pathIndex
+    size_t waveFirstPixel = 0;
+    int waveImageWidth = 0;
+    int waveSamplesPerPixel = 0;
+    uint64_t pathsTraced = 0;
+    uint64_t segmentsTraced = 0;
+
+    // Runs function(chunk, begin, end) for each kWavefrontChunkSize slice of [0, count), on the pool when one is set
+    template <typename Function>
+    void ParallelChunks(size_t count, Function&& function);
+
+    void Generate(const Camera& camera, size_t firstPixel, size_t pixelCount, int imageWidth, int imageHeight,
+        int samplesPerPixel);
+    void Extend(const Scene& scene);
+    void SortByMaterial();
+    void Shade(const Scene& scene);
+    void Compact();
+public:
+    // Same Russian roulette as Renderer::rouletteMinDepth
+    int rouletteMinDepth = 3;
+    // Same role as Renderer::frameIndex; with equal settings both produce the same samples
+    uint32_t frameIndex = 0;
+    // Same role as Renderer::sampler
+    std::shared_ptr<Sampler> sampler;
+
+    // Fills colors with the average of samplesPerPixel paths per pixel, indexed j * imageWidth + i
+    void Render(const Camera& camera, const Scene& scene, int imageWidth, int imageHeight, int samplesPerPixel,
+        int maxDepth, std::vector<Vec3>& colors, ThreadPool* pool = nullptr);
+
+    // Average rays per path in the last Render
+    double AveragePathLength() const { return pathsTraced > 0 ? double(segmentsTraced) / pathsTraced : 0.0; }
+};
@@ -34,6 +34,8 @@ public:
     void SetPitch(float newPitch) { pitch = std::clamp(newPitch, -1.5f, 1.5f); }
     float GetYaw() const { return yaw; }
     void SetYaw(float newYaw) { yaw = newYaw; }
+    float GetAspectRatio() const { return aspectRatio; }
+    void SetAspectRatio(float newAspectRatio) { aspectRatio = newAspectRatio; }
 
     void Pitch(float angle) {
         pitch = std::clamp(pitch + angle, -1.5f, 1.5f);
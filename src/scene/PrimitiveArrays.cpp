@@ -0,0 +1,111 @@
+#include "scene/PrimitiveArrays.h"
+#include <typeinfo>
+
+void PrimitiveArrays::Build(const std::vector<std::shared_ptr<Hittable>>& objects) {
+    Clear();
+    roots.reserve(objects.size());
+    for (const auto& object : objects) {
+        roots.push_back(Compile(object));
+    }
+}
+
+void PrimitiveArrays::Clear() {
+    spheres.clear();
+    cubes.clear();
+    cylinders.clear();
+    planes.clear();
+    triangles.clear();
+    transforms.clear();
+    meshes.clear();
+    others.clear();
+    roots.clear();
+}
+
+uint32_t PrimitiveArrays::Compile(const std::shared_ptr<Hittable>& object) {
+    auto tag = [](PrimitiveType type, size_t index) {
+        return (static_cast<uint32_t>(type) << kTypeShift) | static_cast<uint32_t>(index);
+    };
+    auto other = [&]() {
+        others.push_back(object.get());
+        return tag(PrimitiveType::Other, others.size() - 1);
+    };
+
+    // Exact types only: a subclass may override Hit, so it stays behind the vtable
+    const Hittable& hittable = *object;
+    const std::type_info& type = typeid(hittable);
+
+    if (type == typeid(Sphere)) {
+        spheres.push_back(static_cast<const Sphere&>(hittable));
+        return tag(PrimitiveType::Sphere, spheres.size() - 1);
+    }
+    if (type == typeid(Cube)) {
+        cubes.push_back(static_cast<const Cube&>(hittable));
+        return tag(PrimitiveType::Cube, cubes.size() - 1);
+    }
+    if (type == typeid(Cylinder)) {
+        cylinders.push_back(static_cast<const Cylinder&>(hittable));
+        return tag(PrimitiveType::Cylinder, cylinders.size() - 1);
+    }
+    if (type == typeid(Plane)) {
+        planes.push_back(static_cast<const Plane&>(hittable));
+        return tag(PrimitiveType::Plane, planes.size() - 1);
+    }
+    if (type == typeid(Triangle)) {
+        triangles.push_back(static_cast<const Triangle&>(hittable));
+        return tag(PrimitiveType::Triangle, triangles.size() - 1);
+    }
+    if (type == typeid(Mesh)) {
+        meshes.push_back(static_cast<const Mesh*>(object.get()));
+        return tag(PrimitiveType::Mesh, meshes.size() - 1);
+    }
+    if (type == typeid(Transform)) {
+        const Transform& transform = static_cast<const Transform&>(hittable);
+        // The child is compiled first; the copy keeps it alive through its shared_ptr
+        uint32_t child = Compile(transform.GetObject());
+        transforms.push_back(CompiledTransform{ transform, child });
+        transforms.back().transform.UpdateMatrices();
+        return tag(PrimitiveType::Transform, transforms.size() - 1);
+    }
+    return other();
+}
+
+bool PrimitiveArrays::HitTagged(uint32_t tagged, const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    uint32_t index = tagged & kIndexMask;
+    switch (static_cast<PrimitiveType>(tagged >> kTypeShift)) {
+        case PrimitiveType::Sphere:
+            return spheres[index].Sphere::Hit(ray, tMin, tMax, record);
+        case PrimitiveType::Cube:
+            return cubes[index].Cube::Hit(ray, tMin, tMax, record);
+        case PrimitiveType::Cylinder:
+            return cylinders[index].Cylinder::Hit(ray, tMin, tMax, record);
+        case PrimitiveType::Plane:
+            return planes[index].Plane::Hit(ray, tMin, tMax, record);
+        case PrimitiveType::Triangle:
+            return triangles[index].Triangle::Hit(ray, tMin, tMax, record);
+        case PrimitiveType::Mesh:
+            return meshes[index]->Mesh::Hit(ray, tMin, tMax, record);
+        case PrimitiveType::Transform: {
+            const CompiledTransform& compiled = transforms[index];
+            return compiled.transform.HitWith(ray, tMin, tMax, record,
+                [this, &compiled](const Ray& localRay, float t0, float t1, HitRecord& rec) {
+                    return HitTagged(compiled.child, localRay, t0, t1, rec);
+                });
+        }
+        default:
+            return others[index]->Hit(ray, tMin, tMax, record);
+    }
+}
+
+size_t PrimitiveArrays::Count(PrimitiveType type) const {
+    switch (type) {
+        case PrimitiveType::Sphere: return spheres.size();
+        case PrimitiveType::Cube: return cubes.size();
+        case PrimitiveType::Cylinder: return cylinders.size();
+        case PrimitiveType::Plane: return planes.size();
+        case PrimitiveType::Triangle: return triangles.size();
+        case PrimitiveType::Transform: return transforms.size();
+        case PrimitiveType::Mesh: return meshes.size();
+        case PrimitiveType::Other: return others.size();
+        default: return 0;
+    }
+}
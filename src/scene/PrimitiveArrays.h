@@ -0,0 +1,67 @@
+#pragma once
+#include "geometry/Hittable.h"
+#include "geometry/Sphere.h"
+#include "geometry/Cube.h"
+#include "geometry/Cylinder.h"
+#include "geometry/Plane.h"
+#include "geometry/Triangle.h"
+#include "geometry/Transform.h"
+#include "geometry/Mesh.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class PrimitiveType : uint32_t {
+    Sphere,
+    Cube,
+    Cylinder,
+    Plane,
+    Triangle,
+    Transform,
+    Mesh,
+    Other, // Any other Hittable, reached through its virtual Hit
+    Count
+};
+
+// Scene objects compiled into one contiguous array per primitive type. Each object becomes a tagged index,
+// the type in the top bits and the array slot below, and a hit is a switch on the tag followed by a direct
+// call. Shapes and transforms are copied in, so objects edited after compiling need a recompile, as they
+// already need a BVH rebuild. Transforms refer to their child by tagged index as well.
+class PrimitiveArrays {
+private:
+    static constexpr uint32_t kTypeShift = 28;
+    static constexpr uint32_t kIndexMask = (1u << kTypeShift) - 1;
+
+    struct CompiledTransform {
+        Transform transform;
+        uint32_t child;
+    };
+
+    std::vector<Sphere> spheres;
+    std::vector<Cube> cubes;
+    std::vector<Cylinder> cylinders;
+    std::vector<Plane> planes;
+    std::vector<Triangle> triangles;
+    std::vector<CompiledTransform> transforms;
+    std::vector<const Mesh*> meshes;
+    std::vector<const Hittable*> others;
+
+    // Tagged index of every scene object, in object order
+    std::vector<uint32_t> roots;
+
+    uint32_t Compile(const std::shared_ptr<Hittable>& object);
+    bool HitTagged(uint32_t tagged, const Ray& ray, float tMin, float tMax, HitRecord& record) const;
+public:
+    // Replaces the arrays with the given objects, which must outlive them (meshes and other types are
+    // referenced, not copied)
+    void Build(const std::vector<std::shared_ptr<Hittable>>& objects);
+    void Clear();
+
+    // Number of compiled scene objects; Hit takes indices below this
+    size_t Size() const { return roots.size(); }
+    size_t Count(PrimitiveType type) const;
+
+    bool Hit(uint32_t object, const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+        return HitTagged(roots[object], ray, tMin, tMax, record);
+    }
+};
@@ -1,4 +1,7 @@
 #include "scene/Scene.h"
+#include "utils/MemoryStats.h"
+#include <iostream>
+#include <chrono>
 
 void Scene::Add(std::shared_ptr<Hittable> object) {
     objects.push_back(object);
@@ -6,18 +9,80 @@ void Scene::Add(std::shared_ptr<Hittable> object) {
 
 void Scene::Clear() {
     objects.clear();
+    primitives.Clear();
+    materials.Clear();
+    meshes.clear();
+    meshIds.clear();
+    instances.clear();
+    bvh.Clear();
+    bvhBuilt = false;
+}
+
+uint32_t Scene::AddMesh(std::shared_ptr<Mesh> mesh) {
+    auto found = meshIds.find(mesh.get());
+    if (found != meshIds.end()) return found->second;
+
+    uint32_t id = static_cast<uint32_t>(meshes.size());
+    meshIds[mesh.get()] = id;
+    meshes.push_back(std::move(mesh));
+    return id;
+}
+
+void Scene::AddInstance(uint32_t meshIndex, const Vec3& position, const Vec3& rotation, const Vec3& scale) {
+    instances.emplace_back(meshIndex, position, rotation, scale);
+}
+
+void Scene::AddInstance(std::shared_ptr<Mesh> mesh, const Vec3& position, const Vec3& rotation, const Vec3& scale) {
+    AddInstance(AddMesh(mesh), position, rotation, scale);
+}
+
+void Scene::Compile() {
+    primitives.Build(objects);
+}
+
+void Scene::SetBVHLayout(BVHLayout layout) {
+    bvh.SetLayout(layout);
+    for (const auto& mesh : meshes) {
+        mesh->SetBVHLayout(layout);
+    }
+}
+
+bool Scene::HitPrimitive(uint32_t index, const Ray& ray, float tMin, float tMax, HitRecord& record) const {
+    if (index < objects.size()) {
+        if (index < primitives.Size()) return primitives.Hit(index, ray, tMin, tMax, record);
+        return objects[index]->Hit(ray, tMin, tMax, record);
+    }
+    const MeshInstance& instance = instances[index - objects.size()];
+    return instance.Hit(*meshes[instance.meshIndex], ray, tMin, tMax, record);
+}
+
+bool Scene::PrimitiveBoundingBox(uint32_t index, AABB& outputBox) const {
+    if (index < objects.size()) {
+        return objects[index]->BoundingBox(outputBox);
+    }
+    const MeshInstance& instance = instances[index - objects.size()];
+    AABB localBox;
+    if (!meshes[instance.meshIndex]->BoundingBox(localBox)) {
+        return false;
+    }
+    outputBox = instance.WorldBounds(localBox);
+    return true;
 }
 
 bool Scene::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const {
-    if (bvhBuilt && root) {
-        return root->Hit(ray, tMin, tMax, record);
+    if (bvhBuilt) {
+        return bvh.Hit(ray, tMin, tMax, record,
+            [this](uint32_t index, const Ray& r, float t0, float t1, HitRecord& rec) {
+                return HitPrimitive(index, r, t0, t1, rec);
+            });
     } else {
         HitRecord tempRecord;
         bool hitAnything = false;
         float closestSoFar = tMax;
+        uint32_t primitiveCount = static_cast<uint32_t>(objects.size() + instances.size());
 
-        for (const auto& object : objects) {
-            if (object->Hit(ray, tMin, closestSoFar, tempRecord)) {
+        for (uint32_t i = 0; i < primitiveCount; i++) {
+            if (HitPrimitive(i, ray, tMin, closestSoFar, tempRecord)) {
                 hitAnything = true;
                 closestSoFar = tempRecord.t;
                 record = tempRecord;
@@ -28,25 +93,76 @@ bool Scene::Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const
     }
 }
 
-void Scene::BuildBVH() {
-    if (objects.empty()) return;
-    root = std::make_shared<BVHNode>(objects, 0, objects.size());
+void Scene::HitPacket(RayPacket& packet, float tMin) const {
+    if (!bvhBuilt) {
+        for (int i = 0; i < packet.size; i++) {
+            if (Hit(packet.rays[i], tMin, packet.tMax[i], packet.records[i])) {
+                packet.hit[i] = true;
+                packet.tMax[i] = packet.records[i].t;
+            }
+        }
+        return;
+    }
+
+    bvh.HitPacket(packet, 0, tMin, [&](uint32_t index, int first) {
+        if (index >= objects.size()) {
+            const MeshInstance& instance = instances[index - objects.size()];
+            instance.HitPacket(*meshes[instance.meshIndex], packet, first, tMin);
+            return;
+        }
+        for (int i = first; i < packet.size; i++) {
+            if (HitPrimitive(index, packet.rays[i], tMin, packet.tMax[i], packet.records[i])) {
+                packet.hit[i] = true;
+                packet.tMax[i] = packet.records[i].t;
+            }
+        }
+    });
+}
+
+void Scene::BuildBVH(const BVHBuildOptions& options) {
+    uint32_t primitiveCount = static_cast<uint32_t>(objects.size() + instances.size());
+    if (primitiveCount == 0) return;
+    auto buildStart = std::chrono::steady_clock::now();
+
+    std::vector<AABB> primitiveBounds;
+    primitiveBounds.reserve(primitiveCount);
+    for (uint32_t i = 0; i < primitiveCount; i++) {
+        AABB primitiveBox;
+        if (!PrimitiveBoundingBox(i, primitiveBox)) {
+            std::cerr << "No bounding box for scene object" << std::endl;
+            primitiveBox = AABB::Empty();
+        }
+        primitiveBounds.push_back(primitiveBox);
+    }
+
+    bvh.Build(primitiveBounds, options);
     bvhBuilt = true;
+    Compile();
+
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    std::cout << "Built scene BVH over " << objects.size() << " objects and " << instances.size() << " instances of "
+              << meshes.size() << " meshes in " << buildMs << " ms, SAH cost " << bvh.SAHCost()
+              << ", peak memory " << GetPeakResidentBytes() / (1024 * 1024) << " MB" << std::endl;
 }
 
-bool Scene::BoundingBox(AABB& outputBox) const {
-    if (objects.empty()) return false;
+void Scene::AssignBVH(LinearBVH binary, BVHLayout layout) {
+    bvh.Assign(std::move(binary), layout);
+    bvhBuilt = !bvh.Empty();
+    Compile();
+}
 
-    AABB tempBox;
-    bool firstBox = true;
+bool Scene::BoundingBox(AABB& outputBox) const {
+    uint32_t primitiveCount = static_cast<uint32_t>(objects.size() + instances.size());
+    if (primitiveCount == 0) return false;
 
-    for (const auto& object : objects) {
-        if (!object->BoundingBox(tempBox)) {
+    outputBox = AABB::Empty();
+    for (uint32_t i = 0; i < primitiveCount; i++) {
+        AABB tempBox;
+        if (!PrimitiveBoundingBox(i, tempBox)) {
             return false;
         }
-        outputBox = firstBox ? tempBox : AABB::SurroundingBox(outputBox, tempBox);
-        firstBox = false;
+        outputBox.Expand(tempBox);
     }
 
     return true;
-}
\ No newline at end of file
+}
@@ -1,15 +1,33 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include "geometry/Hittable.h"
-#include "geometry/BVHNode.h"
+#include "geometry/BVH.h"
+#include "geometry/Mesh.h"
+#include "geometry/MeshInstance.h"
+#include "materials/MaterialTable.h"
+#include "scene/PrimitiveArrays.h"
 
 class Scene : public Hittable {
 private:
     std::vector<std::shared_ptr<Hittable>> objects;
-    std::shared_ptr<BVHNode> root;
+    MaterialTable materials;
+
+    // Objects compiled for tracing by Compile; objects added since are still hit through Hittable
+    PrimitiveArrays primitives;
+
+    // Bottom-level structures: each unique mesh owns one BVH, shared by all its instances
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::unordered_map<const Mesh*, uint32_t> meshIds;
+    std::vector<MeshInstance> instances;
+
+    // Top-level BVH over objects followed by instances
+    BVH bvh;
     bool bvhBuilt = false;
 
+    bool HitPrimitive(uint32_t index, const Ray& ray, float tMin, float tMax, HitRecord& record) const;
+    bool PrimitiveBoundingBox(uint32_t index, AABB& outputBox) const;
 public:
     // Constructors
     Scene() = default;
@@ -18,10 +36,44 @@ public:
     // Object management
     void Add(std::shared_ptr<Hittable> object);
     void Clear();
-    void BuildBVH();
+    void BuildBVH(const BVHBuildOptions& options = BVHBuildOptions());
+
+    // Groups the objects into per-type arrays traced without virtual calls; BuildBVH and AssignBVH do this
+    void Compile();
+    const PrimitiveArrays& GetPrimitives() const { return primitives; }
+
+    // Registers a material and returns the id primitives of this scene refer to it by
+    uint32_t AddMaterial(std::shared_ptr<Material> material) { return materials.Add(std::move(material)); }
+    const MaterialTable& GetMaterials() const { return materials; }
+
+    // Registers a mesh as a bottom-level structure and returns its index; adding the same mesh twice returns the same index
+    uint32_t AddMesh(std::shared_ptr<Mesh> mesh);
+    void AddInstance(uint32_t meshIndex, const Vec3& position, const Vec3& rotation, const Vec3& scale);
+    void AddInstance(std::shared_ptr<Mesh> mesh, const Vec3& position, const Vec3& rotation, const Vec3& scale);
+
+    size_t GetObjectCount() const { return objects.size(); }
+    size_t GetInstanceCount() const { return instances.size(); }
+    const std::vector<std::shared_ptr<Hittable>>& GetObjects() const { return objects; }
+    const std::vector<std::shared_ptr<Mesh>>& GetMeshes() const { return meshes; }
+    const std::vector<MeshInstance>& GetInstances() const { return instances; }
+    void AddInstance(const MeshInstance& instance) { instances.push_back(instance); }
+
+    // Top-level BVH, for saving; AssignBVH adopts one saved for the same objects and instances instead of building
+    bool IsBVHBuilt() const { return bvhBuilt; }
+    const BVH& GetBVH() const { return bvh; }
+    void AssignBVH(LinearBVH binary, BVHLayout layout);
+
+    // Switches the scene BVH and every registered mesh to the given traversal layout
+    void SetBVHLayout(BVHLayout layout);
+
+    // SAH cost of the scene BVH, or 0 if it has not been built
+    float GetBVHCost() const { return bvh.SAHCost(); }
 
     // Ray intersection (inherited from Hittable)
     virtual bool Hit(const Ray& ray, float tMin, float tMax, HitRecord& record) const override;
 
+    // Traces a finalized packet; objects are tested ray by ray, mesh instances as a packet
+    void HitPacket(RayPacket& packet, float tMin) const;
+
     virtual bool BoundingBox(AABB& outputBox) const override;
-};
\ No newline at end of file
+};
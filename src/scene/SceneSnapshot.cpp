@@ -0,0 +1,518 @@
+#include "scene/SceneSnapshot.h"
+#include "core/AffineTransform.h"
+#include "geometry/MeshFile.h"
+#include "geometry/Sphere.h"
+#include "geometry/Cube.h"
+#include "geometry/Cylinder.h"
+#include "geometry/Plane.h"
+#include "geometry/Triangle.h"
+#include "geometry/Transform.h"
+#include "materials/Lambertian.h"
+#include "materials/Metal.h"
+#include "materials/Dielectric.h"
+#include "materials/Emissive.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+const char kSceneSnapshotMagic[8] = { 'R', 'T', 'S', 'C', 'E', 'N', 'E', 0 };
+// Transforms nest; deeper chains are rejected rather than recursed into
+constexpr int kMaxObjectDepth = 32;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+};
+
+enum class SnapshotObject : uint32_t {
+    Sphere,
+    Cube,
+    Cylinder,
+    Plane,
+    Triangle,
+    Transform,
+    Mesh
+};
+
+struct SnapshotMaterial {
+    uint32_t type;  // MaterialType
+    Vec3 albedo;
+    float value;    // Dielectric: refractive index, Emissive: emissivity
+};
+
+class SnapshotWriter {
+public:
+    std::vector<unsigned char> bytes;
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values are stored as raw bytes");
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(&value);
+        bytes.insert(bytes.end(), data, data + sizeof(T));
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values are stored as raw bytes");
+        Write(uint64_t(values.size()));
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(values.data());
+        bytes.insert(bytes.end(), data, data + values.size() * sizeof(T));
+    }
+};
+
+class SnapshotReader {
+private:
+    const unsigned char* position;
+    const unsigned char* end;
+public:
+    SnapshotReader(const unsigned char* data, size_t size) : position(data), end(data + size) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values are stored as raw bytes");
+        if (size_t(end - position) < sizeof(T)) return false;
+        std::memcpy(&value, position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    bool ReadArray(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values are stored as raw bytes");
+        uint64_t count;
+        if (!Read(count) || count > size_t(end - position) / sizeof(T)) return false;
+        values.resize(size_t(count));
+        if (count > 0) std::memcpy(values.data(), position, size_t(count) * sizeof(T));
+        position += size_t(count) * sizeof(T);
+        return true;
+    }
+
+    bool AtEnd() const { return position == end; }
+};
+
+// Meshes referenced while writing, numbered in first-use order; material ids are the scene's own
+struct SnapshotTables {
+    size_t materialCount = 0;
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::unordered_map<const Mesh*, uint32_t> meshIndex;
+
+    bool ValidMaterial(uint32_t materialId) const {
+        if (materialId == kNoMaterial || materialId < materialCount) return true;
+        std::cerr << "Error: Scene snapshot object refers to a material the scene does not hold" << std::endl;
+        return false;
+    }
+
+    uint32_t AddMesh(const std::shared_ptr<Mesh>& mesh) {
+        auto found = meshIndex.find(mesh.get());
+        if (found != meshIndex.end()) return found->second;
+        uint32_t index = static_cast<uint32_t>(meshes.size());
+        meshes.push_back(mesh);
+        meshIndex[mesh.get()] = index;
+        return index;
+    }
+};
+
+bool WriteObject(SnapshotWriter& writer, const std::shared_ptr<Hittable>& object, SnapshotTables& tables, int depth) {
+    if (depth > kMaxObjectDepth) {
+        std::cerr << "Error: Transforms nested too deeply for a scene snapshot" << std::endl;
+        return false;
+    }
+    if (auto transform = std::dynamic_pointer_cast<Transform>(object)) {
+        writer.Write(SnapshotObject::Transform);
+        writer.Write(transform->GetPosition());
+        writer.Write(transform->GetRotation());
+        writer.Write(transform->GetScale());
+        return WriteObject(writer, transform->GetObject(), tables, depth + 1);
+    }
+    if (auto mesh = std::dynamic_pointer_cast<Mesh>(object)) {
+        writer.Write(SnapshotObject::Mesh);
+        writer.Write(tables.AddMesh(mesh));
+        return true;
+    }
+    if (auto triangle = std::dynamic_pointer_cast<Triangle>(object)) {
+        writer.Write(SnapshotObject::Triangle);
+        if (!tables.ValidMaterial(triangle->materialId)) return false;
+        writer.Write(triangle->materialId);
+        // Stored as three floats each; the in-memory Vec3A carries a padding lane
+        writer.Write(Vec3(triangle->v0));
+        writer.Write(Vec3(triangle->v1));
+        writer.Write(Vec3(triangle->v2));
+        return true;
+    }
+    if (auto sphere = std::dynamic_pointer_cast<Sphere>(object)) {
+        writer.Write(SnapshotObject::Sphere);
+        if (!tables.ValidMaterial(sphere->materialId)) return false;
+        writer.Write(sphere->materialId);
+        return true;
+    }
+    if (auto cube = std::dynamic_pointer_cast<Cube>(object)) {
+        writer.Write(SnapshotObject::Cube);
+        if (!tables.ValidMaterial(cube->materialId)) return false;
+        writer.Write(cube->materialId);
+        return true;
+    }
+    if (auto cylinder = std::dynamic_pointer_cast<Cylinder>(object)) {
+        writer.Write(SnapshotObject::Cylinder);
+        if (!tables.ValidMaterial(cylinder->materialId)) return false;
+        writer.Write(cylinder->materialId);
+        return true;
+    }
+    if (auto plane = std::dynamic_pointer_cast<Plane>(object)) {
+        writer.Write(SnapshotObject::Plane);
+        if (!tables.ValidMaterial(plane->materialId)) return false;
+        writer.Write(plane->materialId);
+        return true;
+    }
+    std::cerr << "Error: Scene snapshots do not support this object type" << std::endl;
+    return false;
+}
+
+bool WriteMaterial(SnapshotWriter& writer, const Material& material) {
+    SnapshotMaterial record = {};
+    record.type = static_cast<uint32_t>(material.Type());
+    switch (material.Type()) {
+        case MaterialType::Lambertian:
+            record.albedo = static_cast<const Lambertian&>(material).albedo;
+            break;
+        case MaterialType::Metal:
+            record.albedo = static_cast<const Metal&>(material).albedo;
+            break;
+        case MaterialType::Dielectric:
+            record.value = static_cast<const Dielectric&>(material).refractiveIndex;
+            break;
+        case MaterialType::Emissive:
+            record.albedo = static_cast<const Emissive&>(material).albedo;
+            record.value = static_cast<const Emissive&>(material).emissivity;
+            break;
+        default:
+            std::cerr << "Error: Scene snapshots do not support this material type" << std::endl;
+            return false;
+    }
+    writer.Write(record);
+    return true;
+}
+
+void WriteBVH(SnapshotWriter& writer, const BVH& bvh) {
+    writer.Write(static_cast<uint32_t>(bvh.GetLayout()));
+    writer.WriteArray(bvh.GetBinary().GetNodes());
+    writer.WriteArray(bvh.GetBinary().GetPrimitiveIndices());
+}
+
+// Tree structure and leaf references must stay inside the arrays, every node but the root needs exactly one
+// parent, and no node may sit deeper than the builders allow (kMaxBVHDepth), so a damaged file can neither
+// send traversal astray nor overflow its fixed-size stacks
+bool ValidBVH(const std::vector<LinearBVHNode>& nodes, const std::vector<uint32_t>& primitiveIndices, size_t primitiveCount) {
+    // Children always follow their parent, so a forward pass sets a node's depth before visiting it
+    std::vector<uint8_t> hasParent(nodes.size(), 0);
+    std::vector<int> depth(nodes.size(), 0);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const LinearBVHNode& node = nodes[i];
+        if (node.axis > 2 || (i > 0 && !hasParent[i])) return false;
+        if (node.primitiveCount > 0) {
+            if (uint64_t(node.offset) + node.primitiveCount > primitiveIndices.size()) return false;
+            continue;
+        }
+        if (i + 1 >= nodes.size() || node.offset <= i + 1 || node.offset >= nodes.size()) return false;
+        if (depth[i] >= kMaxBVHDepth) return false;
+        for (size_t child : { i + 1, size_t(node.offset) }) {
+            if (hasParent[child]) return false;
+            hasParent[child] = 1;
+            depth[child] = depth[i] + 1;
+        }
+    }
+    for (uint32_t index : primitiveIndices) {
+        if (index >= primitiveCount) return false;
+    }
+    return true;
+}
+
+bool ReadBVH(SnapshotReader& reader, LinearBVH& bvh, BVHLayout& layout, size_t primitiveCount) {
+    uint32_t storedLayout;
+    std::vector<LinearBVHNode> nodes;
+    std::vector<uint32_t> primitiveIndices;
+    if (!reader.Read(storedLayout) || storedLayout > static_cast<uint32_t>(BVHLayout::Wide8)) return false;
+    if (!reader.ReadArray(nodes) || !reader.ReadArray(primitiveIndices)) return false;
+    if (!ValidBVH(nodes, primitiveIndices, primitiveCount)) return false;
+    layout = static_cast<BVHLayout>(storedLayout);
+    bvh.Assign(std::move(nodes), std::move(primitiveIndices));
+    return true;
+}
+
+template <int Width>
+bool ValidPacks(const std::vector<TrianglePack<Width>>& packs, size_t triangleCount) {
+    for (const TrianglePack<Width>& pack : packs) {
+        if (pack.count == 0 || pack.count > uint32_t(Width)) return false;
+        for (uint32_t lane = 0; lane < pack.count; lane++) {
+            if (pack.triangle[lane] >= triangleCount) return false;
+        }
+    }
+    return true;
+}
+
+bool Finite(const Vec3& v) {
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+// Hit code does not check its math, so placements must be finite and invertible before they reach it
+bool ValidPlacement(const AffineTransform& toWorld) {
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++) {
+            if (!std::isfinite(toWorld(row, col))) return false;
+        }
+    }
+    float det = toWorld.Determinant();
+    return std::isfinite(det) && det != 0.0f;
+}
+
+bool ReadMaterial(SnapshotReader& reader, std::shared_ptr<Material>& material) {
+    SnapshotMaterial record;
+    if (!reader.Read(record)) return false;
+    switch (static_cast<MaterialType>(record.type)) {
+        case MaterialType::Lambertian: material = std::make_shared<Lambertian>(record.albedo); return true;
+        case MaterialType::Metal: material = std::make_shared<Metal>(record.albedo); return true;
+        case MaterialType::Dielectric: material = std::make_shared<Dielectric>(record.value); return true;
+        case MaterialType::Emissive: material = std::make_shared<Emissive>(record.albedo, record.value); return true;
+        default: return false;
+    }
+}
+
+bool ReadMesh(SnapshotReader& reader, size_t materialCount, std::shared_ptr<Mesh>& mesh) {
+    uint32_t materialIndex;
+    uint32_t packWidth;
+    std::vector<Vec3> vertices;
+    std::vector<uint32_t> indices;
+    if (!reader.Read(materialIndex) || !reader.Read(packWidth)) return false;
+    if (materialIndex != kNoMaterial && materialIndex >= materialCount) return false;
+    if (packWidth != 1 && packWidth != 4 && packWidth != 8) return false;
+    if (!reader.ReadArray(vertices) || !reader.ReadArray(indices) || indices.size() % 3 != 0) return false;
+    for (uint32_t index : indices) {
+        if (index >= vertices.size()) return false;
+    }
+    size_t triangleCount = indices.size() / 3;
+
+    LinearBVH bvh;
+    BVHLayout layout;
+    std::vector<LinearBVHNode> nodes;
+    std::vector<TrianglePack<4>> packs4;
+    std::vector<TrianglePack<8>> packs8;
+    // The BVH is read after the packs its leaves point into
+    if (!reader.ReadArray(packs4) || !reader.ReadArray(packs8)) return false;
+    if (!ValidPacks(packs4, triangleCount) || !ValidPacks(packs8, triangleCount)) return false;
+    size_t leafCount = packWidth == 8 ? packs8.size() : (packWidth == 4 ? packs4.size() : triangleCount);
+    if (!ReadBVH(reader, bvh, layout, leafCount)) return false;
+
+    mesh = std::make_shared<Mesh>(materialIndex);
+    mesh->AddTriangles(vertices, indices);
+    if (!bvh.Empty()) {
+        mesh->AssignBVH(std::move(bvh), layout, int(packWidth), std::move(packs4), std::move(packs8));
+    }
+    return true;
+}
+
+struct SnapshotContents {
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<std::shared_ptr<Mesh>> meshes;
+};
+
+bool ReadObject(SnapshotReader& reader, const SnapshotContents& contents, std::shared_ptr<Hittable>& object, int depth) {
+    SnapshotObject kind;
+    if (depth > kMaxObjectDepth || !reader.Read(kind)) return false;
+
+    if (kind == SnapshotObject::Transform) {
+        Vec3 position, rotation, scale;
+        std::shared_ptr<Hittable> child;
+        if (!reader.Read(position) || !reader.Read(rotation) || !reader.Read(scale)) return false;
+        if (!Finite(position) || !Finite(rotation) || !Finite(scale)) return false;
+        if (!ValidPlacement(AffineTransform::Compose(position, rotation, scale))) return false;
+        if (!ReadObject(reader, contents, child, depth + 1)) return false;
+        auto transform = std::make_shared<Transform>(child);
+        transform->SetTransform(position, rotation, scale);
+        object = transform;
+        return true;
+    }
+    if (kind == SnapshotObject::Mesh) {
+        uint32_t meshIndex;
+        if (!reader.Read(meshIndex) || meshIndex >= contents.meshes.size()) return false;
+        object = contents.meshes[meshIndex];
+        return true;
+    }
+
+    uint32_t materialIndex;
+    if (!reader.Read(materialIndex)) return false;
+    if (materialIndex != kNoMaterial && materialIndex >= contents.materials.size()) return false;
+    switch (kind) {
+        case SnapshotObject::Sphere: object = std::make_shared<Sphere>(materialIndex); return true;
+        case SnapshotObject::Cube: object = std::make_shared<Cube>(materialIndex); return true;
+        case SnapshotObject::Cylinder: object = std::make_shared<Cylinder>(materialIndex); return true;
+        case SnapshotObject::Plane: object = std::make_shared<Plane>(materialIndex); return true;
+        case SnapshotObject::Triangle: {
+            Vec3 v0, v1, v2;
+            if (!reader.Read(v0) || !reader.Read(v1) || !reader.Read(v2)) return false;
+            if ((v1 - v0).Cross(v2 - v0).LengthSquared() == 0.0f) return false;
+            object = std::make_shared<Triangle>(v0, v1, v2, materialIndex);
+            return true;
+        }
+        default: return false;
+    }
+}
+}
+
+bool SaveSceneSnapshot(const Scene& scene, const std::string& path) {
+    SnapshotTables tables;
+    tables.materialCount = scene.GetMaterials().Size();
+    // Instances refer to scene meshes by index, so those keep their numbers
+    for (const auto& mesh : scene.GetMeshes()) tables.AddMesh(mesh);
+
+    SnapshotWriter objects;
+    for (const auto& object : scene.GetObjects()) {
+        if (!WriteObject(objects, object, tables, 0)) return false;
+    }
+
+    SnapshotWriter writer;
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, kSceneSnapshotMagic, sizeof(header.magic));
+    header.version = kSceneSnapshotVersion;
+    header.headerSize = sizeof(SnapshotHeader);
+    writer.Write(header);
+
+    const MaterialTable& materials = scene.GetMaterials();
+    writer.Write(uint32_t(materials.Size()));
+    for (uint32_t id = 0; id < materials.Size(); id++) {
+        if (!WriteMaterial(writer, *materials.Get(id))) return false;
+    }
+
+    // Meshes reached only through objects follow the scene's own and are not added to its mesh list
+    writer.Write(uint32_t(tables.meshes.size()));
+    writer.Write(uint32_t(scene.GetMeshes().size()));
+    for (const auto& mesh : tables.meshes) {
+        if (!mesh->IsBVHBuilt()) mesh->BuildBVH();
+        if (!tables.ValidMaterial(mesh->materialId)) return false;
+        writer.Write(mesh->materialId);
+        writer.Write(uint32_t(mesh->GetPackWidth()));
+        writer.WriteArray(mesh->GetVertices());
+        writer.WriteArray(mesh->GetIndices());
+        writer.WriteArray(mesh->GetPacks4());
+        writer.WriteArray(mesh->GetPacks8());
+        WriteBVH(writer, mesh->GetBVH());
+    }
+
+    writer.Write(uint32_t(scene.GetObjectCount()));
+    writer.bytes.insert(writer.bytes.end(), objects.bytes.begin(), objects.bytes.end());
+
+    writer.Write(uint32_t(scene.GetInstanceCount()));
+    for (const MeshInstance& instance : scene.GetInstances()) {
+        writer.Write(instance.meshIndex);
+        writer.Write(instance.transform.objectToWorld.ToMatrix());
+    }
+
+    // An unbuilt scene is stored with an empty tree and built after loading
+    if (scene.IsBVHBuilt()) {
+        WriteBVH(writer, scene.GetBVH());
+    } else {
+        WriteBVH(writer, BVH());
+    }
+
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (file) file.write(reinterpret_cast<const char*>(writer.bytes.data()), std::streamsize(writer.bytes.size()));
+        if (!file) {
+            std::cerr << "Error: Could not write scene snapshot " << path << std::endl;
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        std::cerr << "Error: Could not write scene snapshot " << path << std::endl;
+        return false;
+    }
+    std::cout << "Saved scene snapshot " << path << " (" << writer.bytes.size() / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+bool LoadSceneSnapshot(const std::string& path, Scene& scene) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        std::cerr << "Error: Could not open scene snapshot " << path << std::endl;
+        return false;
+    }
+    SnapshotReader reader(file.Data(), file.Size());
+    auto fail = [&](const char* message) {
+        std::cerr << "Error: Scene snapshot " << path << ": " << message << std::endl;
+        return false;
+    };
+
+    SnapshotHeader header;
+    if (!reader.Read(header) || std::memcmp(header.magic, kSceneSnapshotMagic, sizeof(header.magic)) != 0) {
+        return fail("not a scene snapshot");
+    }
+    if (header.version != kSceneSnapshotVersion || header.headerSize != sizeof(SnapshotHeader)) {
+        return fail("written by an incompatible version");
+    }
+
+    SnapshotContents contents;
+    uint32_t materialCount;
+    if (!reader.Read(materialCount)) return fail("truncated");
+    for (uint32_t i = 0; i < materialCount; i++) {
+        std::shared_ptr<Material> material;
+        if (!ReadMaterial(reader, material)) return fail("invalid material");
+        contents.materials.push_back(material);
+    }
+
+    uint32_t meshCount;
+    uint32_t sceneMeshCount;
+    if (!reader.Read(meshCount) || !reader.Read(sceneMeshCount)) return fail("truncated");
+    if (sceneMeshCount > meshCount) return fail("invalid mesh count");
+    for (uint32_t i = 0; i < meshCount; i++) {
+        std::shared_ptr<Mesh> mesh;
+        if (!ReadMesh(reader, contents.materials.size(), mesh)) return fail("invalid mesh");
+        contents.meshes.push_back(mesh);
+    }
+
+    uint32_t objectCount;
+    std::vector<std::shared_ptr<Hittable>> objects;
+    if (!reader.Read(objectCount)) return fail("truncated");
+    for (uint32_t i = 0; i < objectCount; i++) {
+        std::shared_ptr<Hittable> object;
+        if (!ReadObject(reader, contents, object, 0)) return fail("invalid object");
+        objects.push_back(object);
+    }
+
+    uint32_t instanceCount;
+    std::vector<MeshInstance> instances;
+    if (!reader.Read(instanceCount)) return fail("truncated");
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        uint32_t meshIndex;
+        Matrix4x4 objectToWorld;
+        if (!reader.Read(meshIndex) || !reader.Read(objectToWorld) || meshIndex >= sceneMeshCount) return fail("invalid instance");
+        AffineTransform toWorld = AffineTransform::FromMatrix(objectToWorld);
+        if (!ValidPlacement(toWorld)) return fail("invalid instance");
+        instances.emplace_back(meshIndex, toWorld);
+    }
+
+    LinearBVH bvh;
+    BVHLayout layout;
+    if (!ReadBVH(reader, bvh, layout, objects.size() + instances.size())) return fail("invalid scene BVH");
+    if (!reader.AtEnd()) return fail("unexpected data after the scene");
+
+    // Freshly read materials are all distinct, so they get back the ids the objects store
+    scene.Clear();
+    for (const auto& material : contents.materials) scene.AddMaterial(material);
+    for (uint32_t i = 0; i < sceneMeshCount; i++) scene.AddMesh(contents.meshes[i]);
+    for (const auto& object : objects) scene.Add(object);
+    for (const MeshInstance& instance : instances) scene.AddInstance(instance);
+    if (!bvh.Empty()) scene.AssignBVH(std::move(bvh), layout);
+
+    std::cout << "Loaded scene snapshot " << path << ": " << objects.size() << " objects, " << instances.size()
+              << " instances of " << sceneMeshCount << " meshes" << std::endl;
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "scene/Scene.h"
+#include <string>
+
+// Scene snapshot: materials, objects (with their transforms), meshes with their triangle BVHs and leaf packs,
+// instance transforms and the top-level BVH in one versioned binary file. Loading maps the file and copies
+// the arrays out, so a scene is ready to trace without parsing a model or building a BVH; only the wide BVH
+// layouts are collapsed again from the stored binary trees.
+//
+// Supported objects are Sphere, Cube, Cylinder, Plane, Triangle, Mesh and Transforms of these; supported
+// materials are Lambertian, Metal, Dielectric and Emissive.
+
+constexpr uint32_t kSceneSnapshotVersion = 1;
+
+// Builds any missing mesh BVHs, then writes the snapshot; false with a message on std::cerr for
+// unsupported objects or materials or when the file cannot be written
+bool SaveSceneSnapshot(const Scene& scene, const std::string& path);
+
+// Replaces the contents of scene with a snapshot. Fails without touching scene if the file is missing,
+// from another version, or malformed.
+bool LoadSceneSnapshot(const std::string& path, Scene& scene);
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+// Peak resident set size of the process in bytes, or 0 where it cannot be queried
+inline size_t GetPeakResidentBytes() {
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,104 @@
+#include "utils/RenderStats.h"
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace {
+struct StatsRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadStatsBlock>> blocks;
+    std::vector<ThreadStatsBlock*> freeBlocks;
+};
+
+StatsRegistry& Registry() {
+    // Never destroyed, so threads exiting during shutdown can still release their blocks
+    static StatsRegistry* registry = new StatsRegistry();
+    return *registry;
+}
+
+// Returns the thread's block to the registry when the thread exits
+struct ThreadStatsRelease {
+    ThreadStatsBlock* block = nullptr;
+    ~ThreadStatsRelease() {
+        if (!block) return;
+        StatsRegistry& registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.freeBlocks.push_back(block);
+    }
+};
+}
+
+ThreadStatsBlock* RegisterThreadStats() {
+    thread_local ThreadStatsRelease release;
+    StatsRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!registry.freeBlocks.empty()) {
+        release.block = registry.freeBlocks.back();
+        registry.freeBlocks.pop_back();
+        return release.block;
+    }
+    auto block = std::make_unique<ThreadStatsBlock>();
+    for (auto& counter : block->counters) counter.store(0, std::memory_order_relaxed);
+    for (auto& rays : block->raysPerDepth) rays.store(0, std::memory_order_relaxed);
+    release.block = block.get();
+    registry.blocks.push_back(std::move(block));
+    return release.block;
+}
+
+RenderStats CollectRenderStats() {
+    RenderStats total;
+    StatsRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& block : registry.blocks) {
+        for (int i = 0; i < kStatCounterCount; i++) total.counters[i] += block->counters[i].load(std::memory_order_relaxed);
+        for (int d = 0; d < kStatDepthBuckets; d++) total.raysPerDepth[d] += block->raysPerDepth[d].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t RenderStats::TotalRays() const {
+    uint64_t rays = 0;
+    for (uint64_t count : raysPerDepth) rays += count;
+    return rays;
+}
+
+double RenderStats::PerRay(StatCounter counter) const {
+    uint64_t rays = TotalRays();
+    return rays > 0 ? double(Get(counter)) / rays : 0.0;
+}
+
+RenderStats& RenderStats::operator+=(const RenderStats& other) {
+    for (int i = 0; i < kStatCounterCount; i++) counters[i] += other.counters[i];
+    for (int d = 0; d < kStatDepthBuckets; d++) raysPerDepth[d] += other.raysPerDepth[d];
+    return *this;
+}
+
+RenderStats RenderStats::operator-(const RenderStats& other) const {
+    RenderStats difference;
+    for (int i = 0; i < kStatCounterCount; i++) difference.counters[i] = counters[i] - other.counters[i];
+    for (int d = 0; d < kStatDepthBuckets; d++) difference.raysPerDepth[d] = raysPerDepth[d] - other.raysPerDepth[d];
+    return difference;
+}
+
+std::string FormatRenderStats(const RenderStats& stats) {
+#if RT_ENABLE_STATS
+    std::ostringstream out;
+    out.precision(3);
+    out << "rays by depth";
+    int lastDepth = kStatDepthBuckets - 1;
+    while (lastDepth > 0 && stats.raysPerDepth[lastDepth] == 0) lastDepth--;
+    for (int d = 0; d <= lastDepth; d++) {
+        out << (d == 0 ? " " : "/") << stats.raysPerDepth[d];
+    }
+    out << ", nodes/ray " << stats.PerRay(StatCounter::NodeVisits)
+        << ", boxes/ray " << stats.PerRay(StatCounter::AABBTests)
+        << ", tris/ray " << stats.PerRay(StatCounter::TriangleTests)
+        << ", spheres/ray " << stats.PerRay(StatCounter::SphereTests)
+        << ", other prims/ray " << stats.PerRay(StatCounter::OtherPrimitiveTests);
+    return out.str();
+#else
+    (void)stats;
+    return "stats disabled";
+#endif
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Building with RT_ENABLE_STATS=0 compiles every counter below out of the hot paths
+#ifndef RT_ENABLE_STATS
+#define RT_ENABLE_STATS 1
+#endif
+
+enum class StatCounter {
+    NodeVisits,     // BVH nodes popped during traversal, including wide nodes and the object tree
+    AABBTests,      // Ray-box tests; a wide node tests one box per child, a packet interval test counts once
+    TriangleTests,  // Ray-triangle tests, one per triangle of a TrianglePack
+    SphereTests,
+    OtherPrimitiveTests, // Planes, cubes and cylinders
+    Count
+};
+constexpr int kStatCounterCount = static_cast<int>(StatCounter::Count);
+
+// Rays cast per bounce depth; the last bucket also holds every deeper bounce
+constexpr int kStatDepthBuckets = 8;
+
+// Counters summed over threads, e.g. over one frame
+struct RenderStats {
+    uint64_t counters[kStatCounterCount] = {};
+    uint64_t raysPerDepth[kStatDepthBuckets] = {};
+
+    uint64_t Get(StatCounter counter) const { return counters[static_cast<int>(counter)]; }
+    uint64_t TotalRays() const;
+    // Counter per ray cast, 0 if no ray was cast
+    double PerRay(StatCounter counter) const;
+
+    RenderStats& operator+=(const RenderStats& other);
+    RenderStats operator-(const RenderStats& other) const;
+};
+
+// Counters of one thread; only the owning thread writes them, so relaxed loads and stores suffice
+struct ThreadStatsBlock {
+    std::atomic<uint64_t> counters[kStatCounterCount];
+    std::atomic<uint64_t> raysPerDepth[kStatDepthBuckets];
+
+    static void Add(std::atomic<uint64_t>& value, uint64_t count) {
+        value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+};
+
+// Registers a block for the calling thread; blocks of exited threads are handed to new ones and keep their counts
+ThreadStatsBlock* RegisterThreadStats();
+
+inline ThreadStatsBlock& ThreadStats() {
+    // A plain pointer needs no thread_local init guard, keeping the fast path to one TLS load and a test
+    thread_local ThreadStatsBlock* block = nullptr;
+    if (!block) block = RegisterThreadStats();
+    return *block;
+}
+
+// Totals over all threads since startup; subtract an earlier snapshot to get the counts of a frame
+RenderStats CollectRenderStats();
+
+// One-line summary for the FPS line: rays per path depth and per-ray traversal costs
+std::string FormatRenderStats(const RenderStats& stats);
+
+// Counts events in registers and adds them to the thread's block when destroyed, for loops too hot
+// for a thread_local access per event
+class LocalStats {
+public:
+#if RT_ENABLE_STATS
+    ~LocalStats() {
+        ThreadStatsBlock& block = ThreadStats();
+        for (int i = 0; i < kStatCounterCount; i++) {
+            if (counts[i]) ThreadStatsBlock::Add(block.counters[i], counts[i]);
+        }
+    }
+    void Add(StatCounter counter, uint64_t count = 1) { counts[static_cast<int>(counter)] += count; }
+private:
+    uint64_t counts[kStatCounterCount] = {};
+#else
+    void Add(StatCounter, uint64_t = 1) {}
+#endif
+};
+
+#if RT_ENABLE_STATS
+#define RT_STAT_ADD(counter, count) ThreadStatsBlock::Add(ThreadStats().counters[static_cast<int>(counter)], (count))
+#define RT_STAT_RAYS(depth, count) ThreadStatsBlock::Add(ThreadStats().raysPerDepth[ \
+    (depth) < kStatDepthBuckets - 1 ? (depth) : kStatDepthBuckets - 1], (count))
+#else
+#define RT_STAT_ADD(counter, count) ((void)0)
+#define RT_STAT_RAYS(depth, count) ((void)0)
+#endif
+#define RT_STAT_INC(counter) RT_STAT_ADD(counter, 1)
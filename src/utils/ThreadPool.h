@@ -71,6 +71,20 @@ public:
             });
         }
     }
+
+    // Run function(i) for every i in [0, count) and wait for all of them to finish
+    void ParallelFor(int count, std::function<void(int)> function) {
+        std::vector<RenderTask> tasks;
+        tasks.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            tasks.push_back(RenderTask{ i, i + 1 });
+        }
+        SubmitAndWait(tasks, [&function](const RenderTask& task) {
+            function(task.startRow);
+        });
+    }
+
+    int Size() const { return static_cast<int>(threads.size()); }
 private:
     // Worker thread function
     void WorkerThread() {
@@ -0,0 +1,148 @@
+// Checks that LoadSceneSnapshot rejects damaged files instead of handing them to traversal: a truncated
+// snapshot, one whose BVH points at primitives the scene does not hold, and one whose BVH is deeper than
+// the traversal stacks. Each case starts from a snapshot written by SaveSceneSnapshot.
+#include "scene/SceneSnapshot.h"
+#include "geometry/Sphere.h"
+#include "geometry/Transform.h"
+#include "materials/Lambertian.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+int failures = 0;
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// objectCount unit spheres in a row, with the scene BVH built
+void BuildSpheres(Scene& scene, int objectCount) {
+    uint32_t material = scene.AddMaterial(std::make_shared<Lambertian>(Vec3(0.5f, 0.5f, 0.5f)));
+    for (int i = 0; i < objectCount; i++) {
+        auto sphere = std::make_shared<Transform>(std::make_shared<Sphere>(material));
+        sphere->SetTransform(Vec3(float(i) * 3.0f, 0, 0), Vec3(0, 0, 0), Vec3(1, 1, 1));
+        scene.Add(sphere);
+    }
+    scene.BuildBVH();
+}
+
+std::vector<unsigned char> ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::vector<unsigned char>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+}
+
+template <typename T>
+void Append(std::vector<unsigned char>& bytes, const T& value) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(&value);
+    bytes.insert(bytes.end(), data, data + sizeof(T));
+}
+
+// Size of the scene BVH section that ends every snapshot: layout, node array and primitive index array
+size_t SceneBVHSize(const Scene& scene) {
+    const LinearBVH& binary = scene.GetBVH().GetBinary();
+    return sizeof(uint32_t) + sizeof(uint64_t) + binary.GetNodes().size() * sizeof(LinearBVHNode)
+        + sizeof(uint64_t) + binary.GetPrimitiveIndices().size() * sizeof(uint32_t);
+}
+
+// Replaces the scene BVH with a chain: interior node i has interior node i + 1 as its first child and a
+// leaf as its second, so the deepest leaf sits at depth primitiveCount - 1
+std::vector<unsigned char> WithChainBVH(std::vector<unsigned char> bytes, const Scene& scene, uint32_t primitiveCount) {
+    bytes.resize(bytes.size() - SceneBVHSize(scene));
+
+    uint32_t interiorCount = primitiveCount - 1;
+    std::vector<LinearBVHNode> nodes(2 * interiorCount + 1);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        LinearBVHNode& node = nodes[i];
+        for (int a = 0; a < 3; a++) {
+            node.boundsMin[a] = -1000.0f;
+            node.boundsMax[a] = 1000.0f;
+        }
+        if (i < interiorCount) {
+            node.offset = 2 * interiorCount - uint32_t(i);
+        } else {
+            node.offset = uint32_t(i - interiorCount);
+            node.primitiveCount = 1;
+        }
+    }
+
+    Append(bytes, static_cast<uint32_t>(BVHLayout::Binary));
+    Append(bytes, uint64_t(nodes.size()));
+    for (const LinearBVHNode& node : nodes) Append(bytes, node);
+    Append(bytes, uint64_t(primitiveCount));
+    for (uint32_t i = 0; i < primitiveCount; i++) Append(bytes, i);
+    return bytes;
+}
+
+// Snapshot of objectCount spheres whose scene BVH is a chain with its deepest leaf at depth objectCount - 1
+std::vector<unsigned char> ChainSnapshot(const std::string& path, int objectCount) {
+    Scene scene;
+    BuildSpheres(scene, objectCount);
+    if (!SaveSceneSnapshot(scene, path)) return {};
+    return WithChainBVH(ReadFile(path), scene, uint32_t(objectCount));
+}
+
+// Writes bytes to path and loads them into scene
+bool Load(const std::string& path, const std::vector<unsigned char>& bytes, Scene& scene) {
+    WriteFile(path, bytes);
+    return LoadSceneSnapshot(path, scene);
+}
+}
+
+int main() {
+    std::string path = (std::filesystem::temp_directory_path() / "rt_snapshot_test.rtscene").string();
+
+    Scene source;
+    BuildSpheres(source, 101);
+    Check(SaveSceneSnapshot(source, path), "saving a snapshot");
+    std::vector<unsigned char> valid = ReadFile(path);
+
+    Scene scene;
+    Check(Load(path, valid, scene), "loading an intact snapshot");
+    Check(scene.GetObjectCount() == 101, "intact snapshot restores every object");
+    HitRecord record;
+    Check(scene.Hit(Ray(Vec3(0, 0, -5), Vec3(0, 0, 1)), 0.001f, 1e30f, record), "loaded scene can be traced");
+
+    Scene untouched;
+    BuildSpheres(untouched, 1);
+
+    std::vector<unsigned char> truncated(valid.begin(), valid.end() - 10);
+    Check(!Load(path, truncated, untouched), "truncated snapshot is rejected");
+    std::vector<unsigned char> cut(valid.begin(), valid.begin() + valid.size() / 2);
+    Check(!Load(path, cut, untouched), "snapshot cut in half is rejected");
+
+    // The file ends with the scene BVH's primitive indices
+    std::vector<unsigned char> badIndex = valid;
+    uint32_t outOfRange = 101;
+    std::memcpy(&badIndex[badIndex.size() - sizeof(uint32_t)], &outOfRange, sizeof(uint32_t));
+    Check(!Load(path, badIndex, untouched), "snapshot with an out-of-range primitive index is rejected");
+
+    Check(!Load(path, ChainSnapshot(path, 101), untouched), "snapshot with a 100-deep BVH is rejected");
+    Check(!Load(path, ChainSnapshot(path, kMaxBVHDepth + 2), untouched), "BVH one level past the depth limit is rejected");
+
+    // The same chain at the depth limit is a valid tree, so the rejections above are down to depth alone
+    Scene chain;
+    Check(Load(path, ChainSnapshot(path, kMaxBVHDepth + 1), chain), "snapshot with a BVH at the depth limit loads");
+    Check(chain.Hit(Ray(Vec3(0, 0, -5), Vec3(0, 0, 1)), 0.001f, 1e30f, record), "chain BVH can be traced");
+
+    Check(untouched.GetObjectCount() == 1, "rejected snapshots leave the scene untouched");
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    if (failures > 0) return 1;
+    std::cout << "All scene snapshot checks passed" << std::endl;
+    return 0;
+}